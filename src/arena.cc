@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "arena.hh"
+
+#include <algorithm>
+
+namespace
+{
+
+// Every allocation gets rounded up to this, so all of them stay
+// aligned within blocks, which operator new[] aligns for any type.
+const std::size_t alignment{alignof(std::max_align_t)};
+
+std::size_t aligned(std::size_t size)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+}
+
+Arena::Block::Block(std::size_t size)
+    : data(new char[size]), size(size), used(0)
+{
+}
+
+Arena::Arena(std::size_t block_size)
+    : block_size_(block_size), current_(nullptr), allocations_(0)
+{
+}
+
+void * Arena::allocate(std::size_t size)
+{
+    size = aligned(std::max<std::size_t>(size, 1));
+    ++allocations_;
+
+    // large ones get a block of their own, leaving the current one be
+    if (size > block_size_ / 4)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks_.emplace_back(size);
+        blocks_.back().used = size;
+        return blocks_.back().data.get();
+    }
+
+    while (true)
+    {
+        Block * block(current_.load(std::memory_order_acquire));
+        if (block)
+        {
+            const std::size_t offset(block->used.fetch_add(size, std::memory_order_relaxed));
+            if (offset + size <= block->size)
+                return block->data.get() + offset;
+        }
+
+        // the block is full, the first thread to notice replaces it
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_.load(std::memory_order_relaxed) == block)
+        {
+            blocks_.emplace_back(block_size_);
+            current_.store(&blocks_.back(), std::memory_order_release);
+        }
+    }
+}
+
+std::size_t Arena::allocations() const
+{
+    return allocations_;
+}
+
+std::size_t Arena::blocks() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+}
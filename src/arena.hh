@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_ARENA_HH
+#define ACHARTS_ARENA_HH 1
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Monotonic memory for one render.  Allocations bump a pointer within
+ * large blocks, and nothing is released before the arena itself, so
+ * the many short vectors of a scene cost neither malloc nor free.
+ * Safe to allocate from several threads.
+ */
+class Arena
+{
+public:
+    explicit Arena(std::size_t block_size = 1 << 20);
+    Arena(const Arena &) = delete;
+    Arena & operator=(const Arena &) = delete;
+
+    // Aligned for any fundamental type.
+    void * allocate(std::size_t size);
+
+    // Allocations served, each of them one less for the heap, and
+    // blocks they came from.
+    std::size_t allocations() const;
+    std::size_t blocks() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+        std::atomic<std::size_t> used;
+
+        explicit Block(std::size_t size);
+    };
+
+    const std::size_t block_size_;
+    std::atomic<Block *> current_;
+    std::atomic<std::size_t> allocations_;
+    mutable std::mutex mutex_;
+    // guarded by mutex_, deque keeps blocks in place
+    std::deque<Block> blocks_;
+};
+
+// Allocator drawing from an arena, or from the heap without one.
+template <typename T>
+struct ArenaAllocator
+{
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    Arena * arena;
+
+    ArenaAllocator(Arena * arena = nullptr) noexcept
+        : arena(arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> & rh) noexcept
+        : arena(rh.arena)
+    {
+    }
+
+    T * allocate(std::size_t n)
+    {
+        if (arena)
+            return static_cast<T *>(arena->allocate(n * sizeof(T)));
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T * p, std::size_t) noexcept
+    {
+        if (! arena)
+            ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> & lh, const ArenaAllocator<U> & rh)
+{
+    return lh.arena == rh.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> & lh, const ArenaAllocator<U> & rh)
+{
+    return lh.arena != rh.arena;
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
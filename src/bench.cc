@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ * Throughput and accuracy of projections.  Every projection type
+ * projects synthetic star fields through project() and through
+ * project_many() with each available instruction set and precision.
+ * Errors are measured against the same projections evaluated in long
+ * double, independently of the kernels.  Equidistant projections are
+ * also timed through ReferenceProjection, the way they were computed
+ * before the kernels.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "projection.hh"
+#include "projection_reference.hh"
+
+namespace
+{
+
+const CanvasPoint canvas(297., 210.);
+const ln_equ_posn centre{42.5, 20.};
+
+enum class Shape
+{
+    Azimuthal,
+    Cylindrical,
+    PseudoCylindrical
+};
+
+struct Type
+{
+    const char * name;
+    Shape shape;
+    // field of the wide chart, in degrees of right ascension
+    double wide;
+};
+
+const Type types[] = {
+    {"AzimuthalEquidistant", Shape::Azimuthal, 100.},
+    {"Stereographic", Shape::Azimuthal, 100.},
+    {"Gnomonic", Shape::Azimuthal, 90.},
+    {"Orthographic", Shape::Azimuthal, 100.},
+    {"LambertAzimuthalEqualArea", Shape::Azimuthal, 100.},
+    {"CylindricalEquidistant", Shape::Cylindrical, 360.},
+    {"Mollweide", Shape::PseudoCylindrical, 360.},
+    {"HammerAitoff", Shape::PseudoCylindrical, 360.}
+};
+
+// Field of the narrow chart, in degrees.
+const double narrow{2.};
+
+typedef long double real;
+
+/*
+ * Projections without level rotation, following the conventions of
+ * projection.cc: x grows to the west and y to the south, both scaled
+ * so that the field spans the canvas.
+ */
+class Reference
+{
+public:
+    Reference(const Type & type, double field)
+        : type_(type), name_(type.name)
+    {
+        const real ra(centre.ra * M_PI / 180.), dec(centre.dec * M_PI / 180.);
+        const real field_ra(field * M_PI / 180.), field_dec(field_ra * canvas.y / canvas.x);
+        scale_x_ = -canvas.x / field_ra;
+        scale_y_ = -canvas.y / field_dec;
+        lat_offset_ = 0.;
+
+        switch (type_.shape)
+        {
+            case Shape::Azimuthal:
+                // rows are east, north and the centre
+                set_row(0, -std::sin(ra), std::cos(ra), 0.);
+                set_row(1, -std::sin(dec) * std::cos(ra), -std::sin(dec) * std::sin(ra), std::cos(dec));
+                set_row(2, std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra), std::sin(dec));
+                break;
+            case Shape::Cylindrical:
+                // the centre's meridian on longitude 0
+                set_row(0, std::cos(ra), std::sin(ra), 0.);
+                set_row(1, -std::sin(ra), std::cos(ra), 0.);
+                set_row(2, 0., 0., 1.);
+                lat_offset_ = dec;
+                break;
+            case Shape::PseudoCylindrical:
+                // the centre on longitude and latitude 0
+                set_row(0, std::cos(dec) * std::cos(ra), std::cos(dec) * std::sin(ra), std::sin(dec));
+                set_row(1, -std::sin(ra), std::cos(ra), 0.);
+                set_row(2, -std::sin(dec) * std::cos(ra), -std::sin(dec) * std::sin(ra), std::cos(dec));
+                break;
+        }
+    }
+
+    // NaN where the projection isn't defined, and also next to the back
+    // meridian of cylindrical projections, where positions may land on
+    // either edge of the map.
+    CanvasPoint project(const SkyVector & v) const
+    {
+        real l[3];
+        for (int i(0); i < 3; ++i)
+            l[i] = m_[i][0] * v.x + m_[i][1] * v.y + m_[i][2] * v.z;
+
+        real x(NAN), y(NAN);
+        const std::string & name(name_);
+        if (type_.shape == Shape::Azimuthal)
+        {
+            const real s(std::hypot(l[0], l[1]));
+            real k(NAN);
+            if (name == "AzimuthalEquidistant")
+                k = 0. == s ? 1. : std::atan2(s, l[2]) / s;
+            else if (name == "Stereographic")
+                k = 2. / (1. + l[2]);
+            else if (name == "Gnomonic")
+                k = l[2] > 0. ? 1. / l[2] : NAN;
+            else if (name == "Orthographic")
+                k = l[2] >= 0. ? 1. : NAN;
+            else if (name == "LambertAzimuthalEqualArea")
+                k = std::sqrt(2. / (1. + l[2]));
+            x = k * l[0];
+            y = k * l[1];
+        }
+        else
+        {
+            const real lon(std::atan2(l[1], l[0])), lat(std::atan2(l[2], std::hypot(l[0], l[1])));
+            if (M_PI - std::fabs(lon) < 1e-6)
+                return CanvasPoint(NAN, NAN);
+
+            if (name == "CylindricalEquidistant")
+            {
+                x = lon;
+                y = lat - lat_offset_;
+            }
+            else if (name == "Mollweide")
+            {
+                // t + sin(t) = pi sin(lat) by bisection, as it's monotonic
+                const real k(M_PI * std::sin(lat));
+                real lo(-M_PI), hi(M_PI);
+                for (int i(0); i < 80; ++i)
+                {
+                    const real t((lo + hi) / 2.);
+                    if (t + std::sin(t) < k)
+                        lo = t;
+                    else
+                        hi = t;
+                }
+                const real t((lo + hi) / 2.);
+                x = lon * std::cos(t / 2.);
+                y = M_PI / 2. * std::sin(t / 2.);
+            }
+            else if (name == "HammerAitoff")
+            {
+                const real w(M_PI / std::sqrt(1. + std::cos(lat) * std::cos(lon / 2.)));
+                x = w * std::cos(lat) * std::sin(lon / 2.);
+                y = w * std::sin(lat) / 2.;
+            }
+        }
+        return CanvasPoint(scale_x_ * x, scale_y_ * y);
+    }
+
+private:
+    void set_row(int i, real x, real y, real z)
+    {
+        m_[i][0] = x;
+        m_[i][1] = y;
+        m_[i][2] = z;
+    }
+
+    const Type & type_;
+    const std::string name_;
+    real m_[3][3];
+    real scale_x_, scale_y_, lat_offset_;
+};
+
+SkyVector normalized(double x, double y, double z)
+{
+    const double r(std::sqrt(x * x + y * y + z * z));
+    return SkyVector(x / r, y / r, z / r);
+}
+
+std::vector<SkyVector> uniform_field(std::size_t n)
+{
+    std::mt19937 gen(1);
+    std::normal_distribution<double> normal;
+    std::vector<SkyVector> ret;
+    while (ret.size() < n)
+        ret.push_back(normalized(normal(gen), normal(gen), normal(gen)));
+    return ret;
+}
+
+// Gaussian clusters, a twentieth of the region's radius wide, centred
+// uniformly within the region.
+std::vector<SkyVector> clustered_field(std::size_t n, const SkyCap & region)
+{
+    static const std::size_t clusters{64}, per_cluster{64};
+    std::mt19937 gen(2);
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> uniform;
+    const double sigma(std::max(region.radius(), 0.2) * M_PI / 180. / 20.);
+
+    std::vector<SkyVector> centres;
+    while (centres.size() < clusters)
+    {
+        const SkyVector c(normalized(normal(gen), normal(gen), normal(gen)));
+        if (region.contains(c))
+            centres.push_back(c);
+    }
+
+    std::vector<SkyVector> ret;
+    while (ret.size() < n)
+    {
+        const SkyVector & c(centres[ret.size() / per_cluster % clusters]);
+        ret.push_back(normalized(c.x + sigma * normal(gen), c.y + sigma * normal(gen), c.z + sigma * normal(gen)));
+    }
+    return ret;
+}
+
+// Best of several runs, in nanoseconds per position.
+template <typename F>
+double time_per_point(F f, std::size_t n)
+{
+    typedef std::chrono::steady_clock clock;
+    double best(INFINITY), total(0.);
+    for (int run(0); run < 3 || total < 0.05; ++run)
+    {
+        const clock::time_point start(clock::now());
+        f();
+        const double elapsed(std::chrono::duration<double>(clock::now() - start).count());
+        best = std::min(best, elapsed);
+        total += elapsed;
+    }
+    return best * 1e9 / n;
+}
+
+// Errors, in mm, of positions within canvas margin of the canvas.
+void report(const std::string & path, double ns, const std::vector<CanvasPoint> & out,
+            const std::vector<CanvasPoint> & reference)
+{
+    static const double margin{10.};
+    double max(0.), sum(0.);
+    std::size_t count(0);
+    for (std::size_t i(0); i < out.size(); ++i)
+    {
+        const CanvasPoint & r(reference[i]);
+        if (out[i].nan() || r.nan()
+            || std::fabs(r.x) > canvas.x / 2. + margin || std::fabs(r.y) > canvas.y / 2. + margin)
+            continue;
+        const double e(std::hypot(out[i].x - r.x, out[i].y - r.y));
+        max = std::max(max, e);
+        sum += e * e;
+        ++count;
+    }
+
+    std::cout << "    " << std::left << std::setw(22) << path << std::right
+              << std::fixed << std::setprecision(1) << std::setw(9) << ns
+              << std::setw(10) << 1e3 / ns
+              << std::scientific << std::setprecision(2)
+              << std::setw(12) << max << std::setw(12) << (count ? std::sqrt(sum / count) : 0.)
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+void bench(const Type & type, double field, const std::string & shape, const std::vector<SkyVector> & stars,
+           const std::shared_ptr<Projection> & projection)
+{
+    const std::size_t n(stars.size());
+    const Reference reference(type, field);
+    std::vector<CanvasPoint> expected(n), out(n);
+    for (std::size_t i(0); i < n; ++i)
+        expected[i] = reference.project(stars[i]);
+
+    std::cout << type.name << ", " << field << " degrees, " << n << ' ' << shape << " stars\n"
+              << "    path                      ns/pt   Mpt/s       max mm      rms mm\n";
+
+    std::vector<ln_equ_posn> equ(n);
+    for (std::size_t i(0); i < n; ++i)
+        equ[i] = stars[i].equ();
+    const double ns(time_per_point([&]() {
+                for (std::size_t i(0); i < n; ++i)
+                    out[i] = projection->project(equ[i]);
+            }, n));
+    report("project()", ns, out, expected);
+
+    const std::string name(type.name);
+    if ("AzimuthalEquidistant" == name || "CylindricalEquidistant" == name)
+    {
+        const ReferenceProjection before("AzimuthalEquidistant" == name
+                                         ? ReferenceProjection::Type::AzimuthalEquidistant
+                                         : ReferenceProjection::Type::CylindricalEquidistant,
+                                         canvas, ln_equ_posn{field, 0.}, centre);
+        const double ns(time_per_point([&]() {
+                    for (std::size_t i(0); i < n; ++i)
+                        out[i] = before.project(equ[i]);
+                }, n));
+        report("before kernels", ns, out, expected);
+    }
+
+    for (int series(0); series < 2; ++series)
+    {
+        // the small field approximation, where the projection has one
+        if (series && ! projection->choose_small_field(0.01))
+            break;
+
+        for (int i(0); i <= static_cast<int>(simd::detect_isa()); ++i)
+        {
+            const simd::Isa isa(static_cast<simd::Isa>(i));
+            if (isa != simd::Isa::Scalar && ! simd::kernels(isa))
+                continue;
+
+            for (auto precision : {simd::Precision::Double, simd::Precision::Single})
+            {
+                if (isa == simd::Isa::Scalar && precision == simd::Precision::Single)
+                    continue;
+
+                projection->isa(isa);
+                projection->precision(precision);
+                const double ns(time_per_point([&]() {
+                            projection->project_many(stars.data(), n, RotationMatrix::identity(), out.data());
+                        }, n));
+                report(std::string(simd::isa_name(isa))
+                       + (precision == simd::Precision::Single ? " single" : " double")
+                       + (series ? " series" : ""), ns, out, expected);
+            }
+        }
+    }
+    projection->choose_small_field(0.);
+    projection->isa(simd::detect_isa());
+    projection->precision(simd::Precision::Double);
+    std::cout << std::endl;
+}
+
+}
+
+int main(int arc, char * arv[])
+{
+    const std::size_t n(arc > 1 ? std::strtoul(arv[1], nullptr, 10) : 1 << 18);
+    if (0 == n)
+    {
+        std::cerr << "Usage: " << arv[0] << " [positions]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<SkyVector> uniform(uniform_field(n));
+    for (auto const & type : types)
+    {
+        for (double field : {type.wide, narrow})
+        {
+            std::shared_ptr<Projection> projection(
+                ProjectionFactory::create(type.name, canvas, ln_equ_posn{field, 0.}, centre));
+            bench(type, field, "uniform", uniform, projection);
+            bench(type, field, "clustered", clustered_field(n, projection->visible_region(0.)), projection);
+        }
+    }
+}
@@ -43,16 +43,18 @@ BezierPoint mirror_bezier(const CanvasPoint & A, const CanvasPoint & B, const Ca
 
 }
 
-BezierCurve interpolate_bezier(const std::vector<CanvasPoint> & curve)
+BezierCurve interpolate_bezier(const CanvasPoint * begin, const CanvasPoint * end, Arena * arena)
 {
-    BezierCurve ret;
+    BezierCurve ret{ArenaAllocator<BezierPoint>(arena)};
+    const std::size_t size(end - begin);
 
-    if (curve.size() < 2)
-        throw InternalError("Trying to bezierize a curve of length " + std::to_string(curve.size()));
+    if (size < 2)
+        throw InternalError("Trying to bezierize a curve of length " + std::to_string(size));
 
-    auto iAm(curve.cbegin()), iA(iAm + 1);
+    ret.reserve(size);
+    auto iAm(begin), iA(iAm + 1);
 
-    if (curve.size() >= 3)
+    if (size >= 3)
     {
         {
             BezierPoint b;
@@ -60,7 +62,7 @@ BezierCurve interpolate_bezier(const std::vector<CanvasPoint> & curve)
             ret.push_back(b);
         }
 
-        for (auto iAp(iA + 1), iA_end(curve.end());
+        for (auto iAp(iA + 1), iA_end(end);
              iAp != iA_end; iAm = iA, iA = iAp, ++iAp)
         {
             CanvasPoint Am(*iAm);
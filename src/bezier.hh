@@ -26,6 +26,7 @@
 #include <cmath>
 #include <vector>
 
+#include "arena.hh"
 #include "canvas.hh"
 
 struct BezierPoint
@@ -33,8 +34,9 @@ struct BezierPoint
     CanvasPoint p, cm, cp, perpendicular;
 };
 
-typedef std::vector<BezierPoint> BezierCurve;
+typedef ArenaVector<BezierPoint> BezierCurve;
 
-BezierCurve interpolate_bezier(const std::vector<CanvasPoint> & curve);
+// Curve through points in [begin, end), allocated from arena if given.
+BezierCurve interpolate_bezier(const CanvasPoint * begin, const CanvasPoint * end, Arena * arena = nullptr);
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "canvas.hh"
+
+#include <limits>
+
+namespace
+{
+
+enum {
+    inside = 0, // 0000
+    left   = 1, // 0001
+    right  = 2, // 0010
+    bottom = 4, // 0100
+    top    = 8  // 1000
+};
+
+int outcode(const CanvasBox & box, const CanvasPoint & p)
+{
+    int code(0);
+
+    if (p.x < box.start.x)
+        code |= left;
+    else if (p.x > box.end.x)
+        code |= right;
+
+    if (p.y < box.start.y)
+        code |= bottom;
+    else if (p.y > box.end.y)
+        code |= top;
+
+    return code;
+}
+
+}
+
+CanvasBox CanvasBox::everything()
+{
+    const double inf(std::numeric_limits<double>::infinity());
+    return CanvasBox{CanvasPoint(-inf, -inf), CanvasPoint(inf, inf)};
+}
+
+CanvasBox CanvasBox::empty()
+{
+    const double inf(std::numeric_limits<double>::infinity());
+    return CanvasBox{CanvasPoint(inf, inf), CanvasPoint(-inf, -inf)};
+}
+
+// Cohen-Sutherland, moving the outer end onto the box's edges until
+// both ends are inside, or on the same outer side of it.
+bool CanvasBox::crosses(CanvasPoint p0, CanvasPoint p1) const
+{
+    int code0 = outcode(*this, p0);
+    int code1 = outcode(*this, p1);
+
+    while (true)
+    {
+        if (!(code0 | code1))
+            return true;
+        else if (code0 & code1)
+            return false;
+
+        CanvasPoint p;
+        int code = code0 ? code0 : code1;
+
+        // use formulas y = y0 + slope * (x - x0), x = x0 + (1 / slope) * (y - y0)
+        if (code & top)
+        {
+            p.x = p0.x + (p1.x - p0.x) * (end.y - p0.y) / (p1.y - p0.y);
+            p.y = end.y;
+        }
+        else if (code & bottom)
+        {
+            p.x = p0.x + (p1.x - p0.x) * (start.y - p0.y) / (p1.y - p0.y);
+            p.y = start.y;
+        }
+        else if (code & right)
+        {
+            p.y = p0.y + (p1.y - p0.y) * (end.x - p0.x) / (p1.x - p0.x);
+            p.x = end.x;
+        }
+        else if (code & left)
+        {
+            p.y = p0.y + (p1.y - p0.y) * (start.x - p0.x) / (p1.x - p0.x);
+            p.x = start.x;
+        }
+
+        if (code == code0)
+        {
+            p0 = p;
+            code0 = outcode(*this, p0);
+        }
+        else
+        {
+            p1 = p;
+            code1 = outcode(*this, p1);
+        }
+    }
+}
@@ -134,4 +134,57 @@ inline double operator*(const CanvasPoint & l, const CanvasPoint & r)
     return l.x * r.x + l.y * r.y;
 }
 
+// Axis aligned rectangle of the canvas, edges included.
+struct CanvasBox
+{
+    CanvasPoint start, end;
+
+    // Viewport of size centred at the origin, grown by margin on every
+    // side.
+    static CanvasBox around(const CanvasPoint & size, double margin)
+    {
+        return CanvasBox{CanvasPoint(-size.x / 2. - margin, -size.y / 2. - margin),
+                         CanvasPoint(size.x / 2. + margin, size.y / 2. + margin)};
+    }
+
+    // The whole plane.
+    static CanvasBox everything();
+    // Contains nothing, grows by extend().
+    static CanvasBox empty();
+
+    bool contains(const CanvasPoint & p) const
+    {
+        return p.x >= start.x && p.y >= start.y && p.x <= end.x && p.y <= end.y;
+    }
+
+    bool overlaps(const CanvasBox & box) const
+    {
+        return start.x <= box.end.x && start.y <= box.end.y && box.start.x <= end.x && box.start.y <= end.y;
+    }
+
+    // Grows to contain p, or box.  NaN coordinates are left out.
+    void extend(const CanvasPoint & p)
+    {
+        if (p.x < start.x)
+            start.x = p.x;
+        if (p.y < start.y)
+            start.y = p.y;
+        if (p.x > end.x)
+            end.x = p.x;
+        if (p.y > end.y)
+            end.y = p.y;
+    }
+
+    void extend(const CanvasBox & box)
+    {
+        if (box.start.x > box.end.x || box.start.y > box.end.y)
+            return;
+        extend(box.start);
+        extend(box.end);
+    }
+
+    // Whether the straight segment from p0 to p1 has any part inside.
+    bool crosses(CanvasPoint p0, CanvasPoint p1) const;
+};
+
 #endif
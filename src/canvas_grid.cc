@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "canvas_grid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const std::size_t CanvasGrid::npos{std::numeric_limits<std::size_t>::max()};
+
+namespace
+{
+
+// Enough for any canvas, and still a few megabytes of heads at most.
+const double max_cells_per_side{1024.};
+
+std::size_t cells(double length, double cell)
+{
+    if (! (length > 0.) || ! (cell > 0.) || ! std::isfinite(length / cell))
+        return 1;
+    return std::size_t(std::max(1., std::min(std::ceil(length / cell), max_cells_per_side)));
+}
+
+double distance(const CanvasPoint & p, const CanvasBox & box)
+{
+    const double dx(std::max({box.start.x - p.x, 0., p.x - box.end.x})),
+        dy(std::max({box.start.y - p.y, 0., p.y - box.end.y}));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+}
+
+CanvasGrid::CanvasGrid(const CanvasBox & area, double cell)
+    : area_(area),
+      columns_(cells(area.end.x - area.start.x, cell)),
+      rows_(cells(area.end.y - area.start.y, cell)),
+      cell_((area.end.x - area.start.x) / columns_, (area.end.y - area.start.y) / rows_),
+      heads_(columns_ * rows_, npos)
+{
+}
+
+double CanvasGrid::cell_for(const CanvasBox & area, std::size_t count)
+{
+    const double boxes_per_cell{4.};
+    return std::sqrt((area.end.x - area.start.x) * (area.end.y - area.start.y) * boxes_per_cell
+                     / std::max<std::size_t>(count, 1));
+}
+
+std::size_t CanvasGrid::column(double x) const
+{
+    const double c(std::floor((x - area_.start.x) / cell_.x));
+    // NaN, and everything left of the area, goes to the first column
+    if (! (c > 0.) || 1 == columns_)
+        return 0;
+    return std::min(std::size_t(std::min(c, max_cells_per_side)), columns_ - 1);
+}
+
+std::size_t CanvasGrid::row(double y) const
+{
+    const double r(std::floor((y - area_.start.y) / cell_.y));
+    if (! (r > 0.) || 1 == rows_)
+        return 0;
+    return std::min(std::size_t(std::min(r, max_cells_per_side)), rows_ - 1);
+}
+
+std::size_t CanvasGrid::insert(const CanvasBox & box)
+{
+    const std::size_t item(boxes_.size());
+    boxes_.push_back(box);
+    for (std::size_t r(row(box.start.y)), r1(row(box.end.y)); r <= r1; ++r)
+    {
+        for (std::size_t c(column(box.start.x)), c1(column(box.end.x)); c <= c1; ++c)
+        {
+            std::size_t & head(heads_[r * columns_ + c]);
+            entries_.push_back(Entry{item, head});
+            head = entries_.size() - 1;
+        }
+    }
+    return item;
+}
+
+bool CanvasGrid::any(const CanvasBox & range) const
+{
+    const std::size_t c0(column(range.start.x)), c1(column(range.end.x)),
+        r0(row(range.start.y)), r1(row(range.end.y));
+    for (std::size_t r(r0); r <= r1; ++r)
+    {
+        for (std::size_t c(c0); c <= c1; ++c)
+        {
+            for (std::size_t e(heads_[r * columns_ + c]); npos != e; e = entries_[e].next)
+            {
+                if (boxes_[entries_[e].item].overlaps(range))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Rings of cells around that of p get searched, until the best box
+// found is closer than anything beyond the rings searched could be.
+std::size_t CanvasGrid::nearest(const CanvasPoint & p) const
+{
+    std::size_t best(npos);
+    double best_distance(std::numeric_limits<double>::infinity());
+
+    const long c(column(p.x)), r(row(p.y)), columns(columns_), rows(rows_);
+    const long rings(std::max({c, columns - 1 - c, r, rows - 1 - r}));
+    for (long ring(0); ring <= rings; ++ring)
+    {
+        for (long y(std::max(r - ring, 0L)); y <= std::min(r + ring, rows - 1); ++y)
+        {
+            // whole rows at the top and bottom of the ring, its ends only
+            // in between
+            const bool edge(y == r - ring || y == r + ring);
+            for (long x(std::max(c - ring, 0L)); x <= std::min(c + ring, columns - 1);
+                 x += (edge || x == c + ring) ? 1 : std::max(1L, c + ring - x))
+            {
+                for (std::size_t e(heads_[y * columns_ + x]); npos != e; e = entries_[e].next)
+                {
+                    const double d(distance(p, boxes_[entries_[e].item]));
+                    if (d < best_distance)
+                    {
+                        best_distance = d;
+                        best = entries_[e].item;
+                    }
+                }
+            }
+        }
+
+        // distance to the nearest side of the searched block, those on
+        // edges of the grid holding everything beyond
+        double bound(std::numeric_limits<double>::infinity());
+        if (c - ring > 0)
+            bound = std::min(bound, p.x - (area_.start.x + (c - ring) * cell_.x));
+        if (c + ring < columns - 1)
+            bound = std::min(bound, area_.start.x + (c + ring + 1) * cell_.x - p.x);
+        if (r - ring > 0)
+            bound = std::min(bound, p.y - (area_.start.y + (r - ring) * cell_.y));
+        if (r + ring < rows - 1)
+            bound = std::min(bound, area_.start.y + (r + ring + 1) * cell_.y - p.y);
+        if (best_distance <= std::max(bound, 0.))
+            break;
+    }
+    return best;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_CANVAS_GRID_HH
+#define ACHARTS_CANVAS_GRID_HH 1
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "canvas.hh"
+
+/*
+ * Uniform grid of cells over an area of the canvas, each listing boxes
+ * overlapping it.  Boxes reaching outside of the area are kept by the
+ * cells on its edges.  With cells sized to hold a few boxes each,
+ * range and nearest queries look at a few cells instead of everything,
+ * and boxes can be added at any time.
+ */
+class CanvasGrid
+{
+public:
+    static const std::size_t npos;
+
+    CanvasGrid(const CanvasBox & area, double cell);
+
+    // Cell size for count boxes spread over area, a few to a cell.
+    static double cell_for(const CanvasBox & area, std::size_t count);
+
+    // Returns the number of box, counting from 0 in order of insertion.
+    std::size_t insert(const CanvasBox & box);
+
+    std::size_t size() const
+    {
+        return boxes_.size();
+    }
+
+    const CanvasBox & box(std::size_t item) const
+    {
+        return boxes_[item];
+    }
+
+    // Calls f(item) once for each box overlapping range.
+    template <typename F>
+    void query(const CanvasBox & range, F f) const;
+
+    // Whether any box overlaps range.
+    bool any(const CanvasBox & range) const;
+
+    // Box closest to p, or npos for an empty grid.
+    std::size_t nearest(const CanvasPoint & p) const;
+
+private:
+    struct Entry
+    {
+        std::size_t item, next;
+    };
+
+    std::size_t column(double x) const;
+    std::size_t row(double y) const;
+
+    CanvasBox area_;
+    std::size_t columns_, rows_;
+    CanvasPoint cell_;
+    std::vector<CanvasBox> boxes_;
+    // first entry of each cell's list, and entries of all lists
+    std::vector<std::size_t> heads_;
+    std::vector<Entry> entries_;
+};
+
+template <typename F>
+void CanvasGrid::query(const CanvasBox & range, F f) const
+{
+    const std::size_t c0(column(range.start.x)), c1(column(range.end.x)),
+        r0(row(range.start.y)), r1(row(range.end.y));
+    for (std::size_t r(r0); r <= r1; ++r)
+    {
+        for (std::size_t c(c0); c <= c1; ++c)
+        {
+            for (std::size_t e(heads_[r * columns_ + c]); npos != e; e = entries_[e].next)
+            {
+                const std::size_t item(entries_[e].item);
+                const CanvasBox & box(boxes_[item]);
+                // a box spanning several cells is reported by the first
+                // of them within range only
+                if (c == std::max(c0, column(box.start.x)) && r == std::max(r0, row(box.start.y))
+                    && box.overlaps(range))
+                    f(item);
+            }
+        }
+    }
+}
+
+#endif
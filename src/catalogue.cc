@@ -22,16 +22,43 @@
  */
 #include "catalogue.hh"
 
+#include <algorithm>
 #include <boost/algorithm/string/trim.hpp>
 #include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 #include "catalogue_description.hh"
 #include "config_parser.hh"
+#include "file_source.hh"
+#include "gzindex.hh"
+#include "gzstream.hh"
 #include "magic.hh"
 #include "stars.hh"
 
+namespace
+{
+
+std::string describe(const CatalogParsingDescription & description)
+{
+    std::ostringstream os;
+    for (auto const & e : description.descriptions)
+        os << e.start << '-' << e.len << ' ' << int(e.field) << ';';
+    return os.str();
+}
+
+struct Loaded
+{
+    std::size_t count = 0;
+    std::vector<Star> stars;
+};
+
+}
+
 struct Catalogue::Implementation
 {
     typedef std::vector<Star> Stars;
@@ -40,11 +67,128 @@ struct Catalogue::Implementation
     std::string path_;
     double mag_limit_ = 100.0;
     CatalogParsingDescription description;
+    bool index_ = false;
+    bool has_region_ = false;
+    double region_ra_ = 0., region_dec_ = 0., region_radius_ = 180.;
 
     Implementation()
         : description(config_parser::parse_catalogue_description(
                           "5-14 Name; 76-77 RAh; 78-79 RAm; 80-83 RAs; 84 DE-; 85-86 DEd; 87-88 DEm; 89-90 DEs; 103-107 Vmag"))
     { }
+
+    void accept(const Star & star, Loaded & loaded) const
+    {
+        ++loaded.count;
+        if (star.vmag_ > mag_limit_)
+            return;
+
+        loaded.stars.push_back(star);
+    }
+
+    Loaded load_lines(BlockSource & source, GzipIndex * index) const
+    {
+        LineReader lines(source);
+        boost::string_ref line;
+        std::uint64_t offset{0};
+        Loaded loaded;
+        while (lines.next(line))
+        {
+            const std::uint64_t line_offset(offset);
+            offset += line.size() + 1;
+            try
+            {
+                Star c{parse_line_into_star(description, line)};
+                if (index)
+                    index->add_line(line_offset, c.pos_.ra, c.pos_.dec);
+                accept(c, loaded);
+            }
+            catch (const std::runtime_error &)
+            {
+                /* skippery */
+            }
+        }
+        return loaded;
+    }
+
+    // Inflates spans [first, last) of index, starting at an access point.
+    Loaded load_spans(const GzipIndex & index, std::size_t first, std::size_t last) const
+    {
+        auto const & points(index.points());
+        const std::uint64_t end(last < points.size() ? points[last].out : std::numeric_limits<std::uint64_t>::max());
+
+        GzipSource source(std::unique_ptr<FileSource>(new FileSource(path_.c_str())), points[first]);
+        LineReader lines(source);
+        boost::string_ref line;
+        std::uint64_t offset(points[first].out);
+
+        // tail of a line belonging to the previous span
+        if (! points[first].line_start() && lines.next(line))
+            offset += line.size() + 1;
+
+        Loaded loaded;
+        while (offset < end && lines.next(line))
+        {
+            offset += line.size() + 1;
+            try
+            {
+                accept(parse_line_into_star(description, line), loaded);
+            }
+            catch (const std::runtime_error &)
+            {
+                /* skippery */
+            }
+        }
+        return loaded;
+    }
+
+    Loaded load_indexed(const GzipIndex & index) const
+    {
+        auto const & points(index.points());
+        std::vector<std::size_t> selected;
+        for (std::size_t i(0); i < points.size(); ++i)
+        {
+            if (! has_region_ || points[i].bounds.intersects_cap(region_ra_, region_dec_, region_radius_))
+                selected.push_back(i);
+        }
+
+        // split runs of consecutive spans into pieces small enough to
+        // keep every worker busy
+        const std::size_t workers(std::max(1u, std::thread::hardware_concurrency()));
+        const std::size_t piece((selected.size() + workers - 1) / workers);
+        std::vector<std::pair<std::size_t, std::size_t>> runs;
+        for (auto i : selected)
+        {
+            if (runs.empty() || runs.back().second != i || runs.back().second - runs.back().first >= piece)
+                runs.push_back(std::make_pair(i, i + 1));
+            else
+                ++runs.back().second;
+        }
+
+        std::vector<std::future<Loaded>> futures;
+        for (std::size_t w(0); w < workers && w < runs.size(); ++w)
+        {
+            futures.push_back(std::async(std::launch::async, [this, &index, &runs, w, workers]()
+                {
+                    Loaded loaded;
+                    for (std::size_t r(w); r < runs.size(); r += workers)
+                    {
+                        Loaded l(load_spans(index, runs[r].first, runs[r].second));
+                        loaded.count += l.count;
+                        loaded.stars.insert(loaded.stars.end(), l.stars.begin(), l.stars.end());
+                    }
+                    return loaded;
+                }));
+        }
+
+        Loaded loaded;
+        for (auto & f : futures)
+        {
+            Loaded l(f.get());
+            loaded.count += l.count;
+            loaded.stars.insert(loaded.stars.end(), l.stars.begin(), l.stars.end());
+        }
+        return loaded;
+    }
 };
 
 Catalogue::Catalogue()
@@ -58,31 +202,43 @@ Catalogue::~Catalogue()
 
 std::size_t Catalogue::load()
 {
-    std::unique_ptr<std::istream> file(open_file_with_magic(imp_->path_.c_str()));
-    if (! file)
-        throw std::runtime_error("Can't open catalog!");
+    std::unique_ptr<BlockSource> source(open_file_with_magic(imp_->path_.c_str()));
+    GzipSource * gzip(dynamic_cast<GzipSource *>(source.get()));
 
-    std::string line;
-    std::size_t count{0};
-    while (std::getline(*file, line))
+    Loaded loaded;
+    // there's no coming back to earlier parts of a pipe, and standard
+    // input has neither a name for the index nor a way to reopen it
+    if (imp_->index_ && gzip && gzip->seekable() && "-" != imp_->path_)
     {
-        try
+        const std::string index_path(imp_->path_ + ".index");
+        const GzipIndex::Key key(imp_->path_, describe(imp_->description));
+        GzipIndex index;
+        if (index.read(index_path, key))
         {
-            Star c{parse_line_into_star(imp_->description, line)};
-            ++count;
-            if (c.vmag_ > imp_->mag_limit_)
-                continue;
-
-            imp_->stars_.push_back(c);
+            source.reset();
+            loaded = imp_->load_indexed(index);
         }
-        catch (const std::runtime_error &)
+        else
         {
-            /* skippery */
+            gzip->build_index(&index);
+            loaded = imp_->load_lines(*source, &index);
+            try
+            {
+                if (! index.points().empty())
+                    index.write(index_path, key);
+            }
+            catch (const std::runtime_error & e)
+            {
+                std::cerr << "Warning: " << e.what() << std::endl;
+            }
         }
     }
+    else
+        loaded = imp_->load_lines(*source, nullptr);
 
-    std::sort(imp_->stars_.begin(), imp_->stars_.end(), Star::by_mag());
-    return count;
+    imp_->stars_ = std::move(loaded.stars);
+    std::stable_sort(imp_->stars_.begin(), imp_->stars_.end(), Star::by_mag());
+    return loaded.count;
 }
 
 const ConstStarIterator Catalogue::begin_stars() const
@@ -130,6 +286,24 @@ void Catalogue::description(const CatalogParsingDescription & description)
     imp_->description = description;
 }
 
+void Catalogue::index(bool enable)
+{
+    imp_->index_ = enable;
+}
+
+bool Catalogue::index() const
+{
+    return imp_->index_;
+}
+
+void Catalogue::region(double ra, double dec, double radius)
+{
+    imp_->has_region_ = true;
+    imp_->region_ra_ = ra;
+    imp_->region_dec_ = dec;
+    imp_->region_radius_ = radius;
+}
+
 const Star & ConstStarIterator::operator*() const
 {
     return cat_->imp_->stars_[index_];
@@ -85,6 +85,11 @@ public:
     void mag_limit(double limit);
     double mag_limit() const;
     void description(const CatalogParsingDescription &);
+    void index(bool enable);
+    bool index() const;
+    // Part of the sky, in catalogue's epoch, that needs to be loaded.
+    // Only honoured by indexed loads, others load everything.
+    void region(double ra, double dec, double radius);
 };
 
 #endif
@@ -22,20 +22,30 @@
  */
 #include "catalogue_description.hh"
 
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 
-double parse_double(const std::string & in)
+namespace
 {
-    std::stringstream s{in};
-    double d(0);
-    s >> d;
-    if (! s)
+
+double parse_double(boost::string_ref in)
+{
+    // fields are short, strtod wants them terminated
+    char buf[64];
+    if (in.size() >= sizeof(buf))
+        throw std::runtime_error(""); // skippery
+    std::memcpy(buf, in.data(), in.size());
+    buf[in.size()] = '\0';
+
+    char * end;
+    double d(std::strtod(buf, &end));
+    if (end == buf)
         throw std::runtime_error(""); // skippery
     return d;
 }
 
-double parse_sign(const std::string & in)
+double parse_sign(boost::string_ref in)
 {
     if ("-" == in)
         return -1;
@@ -43,7 +53,9 @@ double parse_sign(const std::string & in)
     return +1;
 }
 
-const Star parse_line_into_star(const CatalogParsingDescription & description, const std::string & line)
+}
+
+const Star parse_line_into_star(const CatalogParsingDescription & description, boost::string_ref line)
 {
     ln_equ_posn pos{0, 0};
     std::string name;
@@ -55,13 +67,13 @@ const Star parse_line_into_star(const CatalogParsingDescription & description, c
     {
         try
         {
-            std::string part{line.substr(desc.start - 1, desc.len)};
+            boost::string_ref part{line.substr(desc.start - 1, desc.len)};
 
 #define CF CatalogParsingDescription::Field
             switch (desc.field)
             {
                 case CF::Name:
-                    name = part;
+                    name.assign(part.begin(), part.end());
                     break;
                 case CF::RAh:
                     pos.ra += 15.0 * parse_double(part);
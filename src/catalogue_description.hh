@@ -23,6 +23,7 @@
 #ifndef ACHARTS_CATALOGUE_DESCRIPTION_HH
 #define ACHARTS_CATALOGUE_DESCRIPTION_HH
 
+#include <boost/utility/string_ref.hpp>
 #include <vector>
 
 #include "stars.hh"
@@ -51,7 +52,7 @@ public:
     std::vector<Entity> descriptions;
 };
 
-const Star parse_line_into_star(const CatalogParsingDescription & description, const std::string & line);
+const Star parse_line_into_star(const CatalogParsingDescription & description, boost::string_ref line);
 
 extern CatalogParsingDescription descriptions;
 
@@ -31,6 +31,8 @@
 #include <deque>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <sys/stat.h>
 
 #include "config_parser.hh"
 #include "catalogue_description.hh"
@@ -120,6 +122,10 @@ struct Config::Implementation
     std::deque<std::shared_ptr<Track>> tracks;
     std::deque<std::shared_ptr<Grid>> grids;
     std::deque<std::shared_ptr<Tick>> ticks;
+    std::deque<std::shared_ptr<Viewport>> viewports;
+    // sections and entries read, but those only affecting output of
+    // the scene built
+    std::string geometry;
 
     Implementation()
         : current_section("core")
@@ -133,16 +139,19 @@ struct Config::Implementation
 
         add("core.output", "output.svg");
         add("core.stylesheet", "");
+        add("core.scene-cache", "");
         add("core.constellations", boolean{false});
 
         add("catalogue.path", "");
         add("catalogue.epoch", timestamp{});
         add("catalogue.mag-limit", double{100});
+        add("catalogue.index", boolean{false});
         add("catalogue.pattern", "5-14 Name; 76-77 RAh; 78-79 RAm; 80-83 RAs; 84 DE-; 85-86 DEd; 87-88 DEm; 89-90 DEs; 103-107 Vmag");
 
         add("canvas.dimensions.x", length{297.});
         add("canvas.dimensions.y", length{210.});
         add("canvas.outer-margin", length{10.});
+        add("canvas.label-size", length{1.});
 
         add("moon.enable", boolean{false});
 
@@ -153,6 +162,8 @@ struct Config::Implementation
         add("projection.centre.ra", angle{0.});
         add("projection.centre.dec", angle{0.});
         add("projection.level", "none");
+        add("projection.precision", "double");
+        add("projection.tolerance", length{0.01});
 
         add("planets.enable", "");
         add("planets.labels", boolean{true});
@@ -181,10 +192,26 @@ struct Config::Implementation
         add("tick.step", angle{0});
         add("tick.base", angle{0});
         add("tick.display", "as_degrees");
+
+        add("viewport.name", "");
+        add("viewport.type", "AzimuthalEquidistant");
+        add("viewport.centre.ra", angle{0.});
+        add("viewport.centre.dec", angle{0.});
+        add("viewport.dimensions.ra", angle{10.});
+        add("viewport.dimensions.dec", angle{0.});
+        add("viewport.level", "none");
+        add("viewport.position.x", length{0.});
+        add("viewport.position.y", length{0.});
+        add("viewport.size.x", length{50.});
+        add("viewport.size.y", length{50.});
     }
 
     void accept_value(const std::string & path, const std::string & value)
     {
+        if ("core.output" != path && "core.stylesheet" != path && "core.scene-cache" != path
+            && "canvas.outer-margin" != path && "canvas.label-size" != path)
+            geometry += path + ' ' + value + '\n';
+
         try
         {
             auto & i(tree.get_child(path));
@@ -199,6 +226,8 @@ struct Config::Implementation
                     catalogues.back()->epoch(boost::get<timestamp>(option).val());
                 else if ("catalogue.mag-limit" == path)
                     catalogues.back()->mag_limit(boost::get<double>(option));
+                else if ("catalogue.index" == path)
+                    catalogues.back()->index(boost::get<boolean>(option).val);
                 else if ("catalogue.pattern" == path)
                     catalogues.back()->description(config_parser::parse_catalogue_description(boost::get<std::string>(option)));
                 else
@@ -285,6 +314,36 @@ struct Config::Implementation
                 else
                     throw ConfigError("Tried setting unknown tick property: " + path);
             }
+            else if ("viewport" == current_section)
+            {
+                Option option(i.data());
+                boost::apply_visitor(value_parser_visitor(value), option);
+                auto & viewport(*viewports.back());
+                if ("viewport.name" == path)
+                    viewport.name = boost::get<std::string>(option);
+                else if ("viewport.type" == path)
+                    viewport.type = boost::get<std::string>(option);
+                else if ("viewport.centre.ra" == path)
+                    viewport.centre.ra = boost::get<angle>(option).val;
+                else if ("viewport.centre.dec" == path)
+                    viewport.centre.dec = boost::get<angle>(option).val;
+                else if ("viewport.dimensions.ra" == path)
+                    viewport.dimensions.ra = boost::get<angle>(option).val;
+                else if ("viewport.dimensions.dec" == path)
+                    viewport.dimensions.dec = boost::get<angle>(option).val;
+                else if ("viewport.level" == path)
+                    viewport.level = boost::get<std::string>(option);
+                else if ("viewport.position.x" == path)
+                    viewport.position.x = boost::get<length>(option).val;
+                else if ("viewport.position.y" == path)
+                    viewport.position.y = boost::get<length>(option).val;
+                else if ("viewport.size.x" == path)
+                    viewport.size.x = boost::get<length>(option).val;
+                else if ("viewport.size.y" == path)
+                    viewport.size.y = boost::get<length>(option).val;
+                else
+                    throw ConfigError("Tried setting unknown viewport property: " + path);
+            }
             else
                 boost::apply_visitor(value_parser_visitor(value), i.data());
         }
@@ -313,6 +372,14 @@ struct Config::Implementation
             grids.push_back(std::make_shared<Grid>());
         else if ("tick" == section)
             ticks.push_back(std::make_shared<Tick>());
+        else if ("viewport" == section)
+            viewports.push_back(std::make_shared<Viewport>());
+
+        // paths of entries name their section, yet each of repeatable
+        // ones adds something
+        if ("catalogue" == section || "track" == section || "grid" == section || "tick" == section
+            || "viewport" == section)
+            geometry += '[' + section + "]\n";
 
         current_section = section;
     }
@@ -423,6 +490,11 @@ double Config::canvas_margin() const
     return imp_->get<length>("canvas.outer-margin").val;
 }
 
+double Config::label_size() const
+{
+    return imp_->get<length>("canvas.label-size").val;
+}
+
 bool Config::moon() const
 {
     return imp_->get<boolean>("moon.enable").val;
@@ -460,6 +532,16 @@ const std::string Config::projection_level() const
     return imp_->get<std::string>("projection.level");
 }
 
+const std::string Config::projection_precision() const
+{
+    return imp_->get<std::string>("projection.precision");
+}
+
+double Config::projection_tolerance() const
+{
+    return imp_->get<length>("projection.tolerance").val;
+}
+
 double Config::t() const
 {
     timestamp ts(imp_->get<timestamp>("core.t"));
@@ -486,6 +568,31 @@ const std::string Config::output() const
     return imp_->get<std::string>("core.output");
 }
 
+const std::string Config::scene_cache() const
+{
+    return imp_->get<std::string>("core.scene-cache");
+}
+
+const std::string Config::geometry_key() const
+{
+    std::ostringstream os;
+    os.precision(17);
+    os << imp_->geometry;
+    // times as resolved in this run
+    os << "t " << t() << "\nepoch " << epoch() << '\n';
+    for (auto const & track : imp_->tracks)
+        os << "track.start " << track->start.val() << '\n';
+
+    for (auto const & c : imp_->catalogues)
+    {
+        struct stat st;
+        if ("-" == c->path() || 0 != ::stat(c->path().c_str(), &st))
+            return "";
+        os << c->path() << ' ' << st.st_size << ' ' << st.st_mtime << '\n';
+    }
+    return os.str();
+}
+
 const std::vector<std::string> Config::planets() const
 {
     std::string v(imp_->get<std::string>("planets.enable"));
@@ -534,6 +641,11 @@ template<> const std::shared_ptr<Tick> Config::get_collection_item(std::size_t i
     return imp_->ticks[i];
 }
 
+template<> const std::shared_ptr<Viewport> Config::get_collection_item(std::size_t i) const
+{
+    return imp_->viewports[i];
+}
+
 template<> const ConfigIterator<Track> Config::View<Track>::end() const
 {
     return ConfigIterator<Track>(config_, config_->imp_->tracks.size());
@@ -554,6 +666,11 @@ template<> const ConfigIterator<Tick> Config::View<Tick>::end() const
     return ConfigIterator<Tick>(config_, config_->imp_->ticks.size());
 }
 
+template<> const ConfigIterator<Viewport> Config::View<Viewport>::end() const
+{
+    return ConfigIterator<Viewport>(config_, config_->imp_->viewports.size());
+}
+
 template <typename T>
 const std::shared_ptr<T> ConfigIterator<T>::operator->() const
 {
@@ -564,3 +681,4 @@ template const std::shared_ptr<Track> ConfigIterator<Track>::operator->() const;
 template const std::shared_ptr<Catalogue> ConfigIterator<Catalogue>::operator->() const;
 template const std::shared_ptr<Grid> ConfigIterator<Grid>::operator->() const;
 template const std::shared_ptr<Tick> ConfigIterator<Tick>::operator->() const;
+template const std::shared_ptr<Viewport> ConfigIterator<Viewport>::operator->() const;
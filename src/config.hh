@@ -31,6 +31,7 @@
 #include "catalogue.hh"
 #include "grid_and_tick.hh"
 #include "track.hh"
+#include "viewport.hh"
 
 class Config;
 
@@ -101,13 +102,24 @@ public:
     double epoch() const;
     const CanvasPoint canvas_dimensions() const;
     double canvas_margin() const;
+    // Height of labels of objects, for placing them; 0 if they should
+    // be left where they are.
+    double label_size() const;
     const std::string projection_type() const;
     const ln_equ_posn projection_centre() const;
     const ln_equ_posn projection_dimensions() const;
     const std::string projection_level() const;
+    const std::string projection_precision() const;
+    double projection_tolerance() const;
     double t() const;
     const std::string stylesheet() const;
     const std::string output() const;
+    const std::string scene_cache() const;
+    // Everything the scene depends on, but canvas margin and label
+    // size: entries of the configuration, times resolved, and sizes
+    // and modification times of catalogues.  Empty if a catalogue
+    // comes from standard input, or can't be found.
+    const std::string geometry_key() const;
 
     template <typename T>
     struct View;
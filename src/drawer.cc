@@ -29,90 +29,80 @@
 #include <stdexcept>
 
 #include "bezier.hh"
+#include "precession.hh"
 
 const std::vector<CanvasPoint> create_path_from_track(const std::shared_ptr<Projection> & projection,
+                                                      const SkyCap & region,
                                                       const Track & track, const double epoch,
                                                       const std::shared_ptr<const SolarObject> & object)
 {
-    std::vector<CanvasPoint> path;
+    std::vector<ln_equ_posn> coords;
     double step(track.mark_interval / track.interval_ticks);
 
     for (double t(0); t <= track.length.val(); t += step)
-    {
-        auto coord(object->get_equ_coords(track.start.val() + t));
-        path.push_back(projection->project(convert_epoch(coord, JD2000, epoch)));
-    }
+        coords.push_back(object->get_equ_coords(track.start.val() + t));
 
-    return path;
+    const RotationMatrix frame(precession_matrix(JD2000, epoch));
+    if (!may_cross(region, coords, frame))
+        return {};
+    return projection->project_many(coords, frame);
 }
 
-const std::deque<BezierCurve> create_bezier_from_path(const std::shared_ptr<Projection> & projection, const std::vector<ln_equ_posn> & path)
+bool may_cross(const SkyCap & region, const std::vector<ln_equ_posn> & path, const RotationMatrix & frame)
 {
-    std::vector<CanvasPoint> ret;
-    for (auto const & p : path)
+    if (region.min_cos <= -1.)
+        return true;
+
+    // region's centre goes into the path's frame instead, and the path
+    // is close enough if its closest position is within region grown by
+    // the longest segment
+    const SkyVector centre(frame.transposed() * region.centre);
+    SkyVector prev;
+    double min_step(1.), max_cos(-1.);
+    for (auto i(path.begin()); i != path.end(); ++i)
     {
-        ret.push_back(projection->project(p));
+        const SkyVector v(*i);
+        if (i != path.begin())
+            min_step = std::min(min_step, dot(prev, v));
+        max_cos = std::max(max_cos, dot(centre, v));
+        prev = v;
     }
-    return create_bezier_from_path(ret, projection->max_distance());
-}
 
-namespace
-{
+    const double grown(std::acos(std::max(-1., std::min(1., region.min_cos))) +
+                       std::acos(std::max(-1., std::min(1., min_step))));
+    if (grown >= M_PI)
+        return true;
 
-void cut_paths_when_distance_is_big(std::vector<std::vector<CanvasPoint>> & input, double max_distance)
-{
-    auto iter(input.begin());
-    while (input.end() != iter)
-    {
-        if (iter->size() < 2)
-        {
-            iter = input.erase(iter);
-            continue;
-        }
-
-        auto el2(iter->begin());
-        auto el1(el2++);
-        auto iter2(iter);
-        ++iter;
-        while (iter2->end() != el2)
-        {
-            double distance((*el1 - *el2).norm());
-            if (distance > max_distance)
-            {
-                std::vector<CanvasPoint> v2(std::make_move_iterator(el2), std::make_move_iterator(iter2->end()));
-                iter2->erase(el2, iter2->end());
-                ++iter2;
-                iter = input.insert(iter2, std::move(v2));
-                break;
-            }
-            ++el1, ++el2;
-        }
-    }
+    return ! path.empty() && max_cos >= std::cos(grown);
 }
 
+const ArenaVector<BezierCurve> create_bezier_from_path(const std::shared_ptr<Projection> & projection,
+                                                       const std::vector<ln_equ_posn> & path, Arena * arena)
+{
+    const std::vector<CanvasPoint> projected(projection->project_many(path));
+    return create_bezier_from_path(projected.data(), projected.data() + projected.size(),
+                                   projection->max_distance(), arena);
 }
 
-const std::deque<BezierCurve> create_bezier_from_path(const std::vector<CanvasPoint> & path, double max_distance)
+const ArenaVector<BezierCurve> create_bezier_from_path(const CanvasPoint * begin, const CanvasPoint * end,
+                                                       double max_distance, Arena * arena)
 {
-    std::vector<std::vector<CanvasPoint>> input(1);
-    for (auto const & p : path)
-    {
-        if (! p.nan())
-            input.back().push_back(p);
-        else if (! input.back().empty())
-            input.push_back(std::vector<CanvasPoint>());
-    }
-
-    cut_paths_when_distance_is_big(input, max_distance);
-
-    std::deque<BezierCurve> ret;
-    for (auto const & b : input)
+    // runs of visible points, cut where they jump farther than
+    // max_distance, e.g. across the back meridian
+    ArenaVector<BezierCurve> ret{ArenaAllocator<BezierCurve>(arena)};
+    const CanvasPoint * run(begin);
+    for (const CanvasPoint * i(begin); i != end; ++i)
     {
-        if (b.size() < 2)
+        const bool cut(i->nan() || (i != run && (*(i - 1) - *i).norm() > max_distance));
+        if (! cut)
             continue;
 
-        ret.push_back(interpolate_bezier(b));
+        if (i - run >= 2)
+            ret.push_back(interpolate_bezier(run, i, arena));
+        run = i->nan() ? i + 1 : i;
     }
+    if (end - run >= 2)
+        ret.push_back(interpolate_bezier(run, end, arena));
 
     return ret;
 }
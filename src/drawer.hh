@@ -26,17 +26,32 @@
 #include <deque>
 #include <memory>
 
+#include "arena.hh"
 #include "bezier.hh"
 #include "canvas.hh"
 #include "projection.hh"
 #include "solar_object.hh"
 #include "track.hh"
 
+// Empty if the track doesn't come within region.
 const std::vector<CanvasPoint> create_path_from_track(const std::shared_ptr<Projection> & projection,
+                                                      const SkyCap & region,
                                                       const Track & track, const double epoch,
                                                       const std::shared_ptr<const SolarObject> & object);
 
-const std::deque<BezierCurve> create_bezier_from_path(const std::vector<CanvasPoint> & path, double max_distance);
-const std::deque<BezierCurve> create_bezier_from_path(const std::shared_ptr<Projection> & projection, const std::vector<ln_equ_posn> & path);
+// Whether a path, rotated by frame into region's epoch, may come within
+// region.  Points between the path's positions are assumed to be no
+// farther from them than its longest segment.
+bool may_cross(const SkyCap & region, const std::vector<ln_equ_posn> & path,
+               const RotationMatrix & frame = RotationMatrix::identity());
+
+// Curves through runs of visible points in [begin, end), cut where
+// they're farther apart than max_distance.  Allocated from arena, if
+// given.
+const ArenaVector<BezierCurve> create_bezier_from_path(const CanvasPoint * begin, const CanvasPoint * end,
+                                                       double max_distance, Arena * arena = nullptr);
+const ArenaVector<BezierCurve> create_bezier_from_path(const std::shared_ptr<Projection> & projection,
+                                                       const std::vector<ln_equ_posn> & path,
+                                                       Arena * arena = nullptr);
 
 #endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "file_source.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+FileSource::FileSource(const char * path)
+    : fd_(-1), owned_(0 != std::strcmp(path, "-"))
+{
+    fd_ = owned_ ? ::open(path, O_RDONLY) : STDIN_FILENO;
+    if (-1 == fd_)
+        throw std::runtime_error(std::string("Can't open catalogue at ") + path + ": " + std::strerror(errno));
+}
+
+FileSource::~FileSource()
+{
+    if (owned_)
+        ::close(fd_);
+}
+
+std::size_t FileSource::read(char * buf, std::size_t size)
+{
+    while (true)
+    {
+        ssize_t r(::read(fd_, buf, size));
+        if (r >= 0)
+            return r;
+
+        if (EINTR != errno)
+            throw std::runtime_error(std::string("Reading catalogue failed: ") + std::strerror(errno));
+    }
+}
+
+void FileSource::seek(std::uint64_t offset)
+{
+    if (-1 == ::lseek(fd_, offset, SEEK_SET))
+        throw std::runtime_error(std::string("Seeking in catalogue failed: ") + std::strerror(errno));
+}
+
+bool FileSource::seekable() const
+{
+    return -1 != ::lseek(fd_, 0, SEEK_CUR);
+}
+
+const std::size_t BlockSource::block_size;
+
+BlockSource::~BlockSource()
+{
+}
+
+PlainSource::PlainSource(std::unique_ptr<FileSource> file, std::unique_ptr<char[]> buffer, std::size_t pending)
+    : file_(std::move(file)), buffer_(std::move(buffer)), pending_(pending)
+{
+}
+
+std::size_t PlainSource::next_block(const char *& data)
+{
+    std::size_t size(pending_);
+    pending_ = 0;
+    if (0 == size)
+        size = file_->read(buffer_.get(), block_size);
+
+    data = buffer_.get();
+    return size;
+}
+
+LineReader::LineReader(BlockSource & source)
+    : source_(source), pos_(nullptr), end_(nullptr)
+{
+}
+
+bool LineReader::next(boost::string_ref & line)
+{
+    straddling_.clear();
+    while (true)
+    {
+        const char * eol(pos_ == end_ ? nullptr :
+                         static_cast<const char *>(std::memchr(pos_, '\n', end_ - pos_)));
+        if (eol)
+        {
+            if (straddling_.empty())
+                line = boost::string_ref(pos_, eol - pos_);
+            else
+            {
+                straddling_.append(pos_, eol);
+                line = straddling_;
+            }
+            pos_ = eol + 1;
+            return true;
+        }
+
+        straddling_.append(pos_, end_);
+
+        const char * data;
+        std::size_t size(source_.next_block(data));
+        if (0 == size)
+        {
+            pos_ = end_;
+            if (straddling_.empty())
+                return false;
+
+            line = straddling_;
+            return true;
+        }
+        pos_ = data;
+        end_ = data + size;
+    }
+}
+
+blockstreambuf::blockstreambuf(std::unique_ptr<BlockSource> source)
+    : source_(std::move(source))
+{
+}
+
+blockstreambuf::int_type blockstreambuf::underflow()
+{
+    const char * data;
+    std::size_t size(source_->next_block(data));
+    if (0 == size)
+        return traits_type::eof();
+
+    // get area points straight into the source's buffer, nothing is copied
+    char * begin(const_cast<char *>(data));
+    setg(begin, begin, begin + size);
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_FILE_SOURCE_HH
+#define ACHARTS_FILE_SOURCE_HH 1
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+/*
+ * Owns a file descriptor opened once and reads raw bytes from it into
+ * buffers supplied by the caller, bypassing std::filebuf and its
+ * internal buffering.  Path "-" stands for standard input, which is
+ * read but never closed.
+ */
+class FileSource
+{
+    int fd_;
+    bool owned_;
+
+public:
+    explicit FileSource(const char * path);
+    ~FileSource();
+    FileSource(const FileSource &) = delete;
+    FileSource & operator=(const FileSource &) = delete;
+
+    // Returns number of bytes read, 0 at end of file.
+    std::size_t read(char * buf, std::size_t size);
+    void seek(std::uint64_t offset);
+    // False for pipes, terminals and the like.
+    bool seekable() const;
+};
+
+/*
+ * Source of decoded bytes, handed out in blocks living in buffers owned
+ * by the source.
+ */
+class BlockSource
+{
+public:
+    static const std::size_t block_size{128 * 1024};
+
+    virtual ~BlockSource();
+
+    // Points data at the next block and returns its size.  The block is
+    // valid until the following call.  Returns 0 at end of data.
+    virtual std::size_t next_block(const char *& data) = 0;
+};
+
+class PlainSource
+    : public BlockSource
+{
+    std::unique_ptr<FileSource> file_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t pending_;
+
+public:
+    // buffer holds pending bytes already read from file.
+    PlainSource(std::unique_ptr<FileSource> file, std::unique_ptr<char[]> buffer, std::size_t pending);
+
+    std::size_t next_block(const char *& data) override;
+};
+
+/*
+ * Splits decoded blocks into lines.  Lines are views into the source's
+ * buffer; only a line straddling two blocks is copied aside.
+ */
+class LineReader
+{
+    BlockSource & source_;
+    const char * pos_;
+    const char * end_;
+    std::string straddling_;
+
+public:
+    explicit LineReader(BlockSource & source);
+    LineReader(const LineReader &) = delete;
+
+    // Points line at the next line, without its terminator.  The view is
+    // valid until the following call.  Returns false at end of data.
+    bool next(boost::string_ref & line);
+};
+
+class blockstreambuf
+    : public std::streambuf
+{
+    std::unique_ptr<BlockSource> source_;
+
+public:
+    explicit blockstreambuf(std::unique_ptr<BlockSource> source);
+    blockstreambuf(const blockstreambuf &) = delete;
+
+    int_type underflow() override;
+};
+
+class iblockstream
+    : public std::istream
+{
+    blockstreambuf blockstreambuf_;
+
+public:
+    explicit iblockstream(std::unique_ptr<BlockSource> source)
+        : std::istream(), blockstreambuf_(std::move(source))
+    {
+        this->init(&blockstreambuf_);
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "gzindex.hh"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace
+{
+
+const char index_magic[8] = { 'A', 'C', 'I', 'D', 'X', '0', '1', '\n' };
+
+template <typename T>
+void put(std::ostream & os, const T & t)
+{
+    os.write(reinterpret_cast<const char *>(&t), sizeof(t));
+}
+
+template <typename T>
+bool get(std::istream & is, T & t)
+{
+    return bool(is.read(reinterpret_cast<char *>(&t), sizeof(t)));
+}
+
+const double deg2rad(M_PI / 180.);
+
+}
+
+SkyBox::SkyBox()
+    : ra_min(std::numeric_limits<float>::max()), ra_max(-std::numeric_limits<float>::max()),
+      dec_min(std::numeric_limits<float>::max()), dec_max(-std::numeric_limits<float>::max())
+{
+}
+
+bool SkyBox::empty() const
+{
+    return ra_min > ra_max;
+}
+
+void SkyBox::add(double ra, double dec)
+{
+    // widen by float's rounding, the box must stay conservative
+    float r(ra), d(dec);
+    ra_min = std::min(ra_min, std::nextafter(r, -std::numeric_limits<float>::max()));
+    ra_max = std::max(ra_max, std::nextafter(r, std::numeric_limits<float>::max()));
+    dec_min = std::min(dec_min, std::nextafter(d, -std::numeric_limits<float>::max()));
+    dec_max = std::max(dec_max, std::nextafter(d, std::numeric_limits<float>::max()));
+}
+
+bool SkyBox::intersects_cap(double ra, double dec, double radius) const
+{
+    if (empty())
+        return false;
+
+    if (dec_min > dec + radius || dec_max < dec - radius)
+        return false;
+
+    // a cap containing a pole spans all right ascensions
+    if (std::fabs(dec) + radius >= 90.)
+        return true;
+
+    double half(std::asin(std::sin(radius * deg2rad) / std::cos(dec * deg2rad)) / deg2rad);
+    for (double shift : { -360., 0., 360. })
+    {
+        if (ra - half + shift <= ra_max && ra + half + shift >= ra_min)
+            return true;
+    }
+    return false;
+}
+
+bool GzipIndex::AccessPoint::line_start() const
+{
+    return 0 == out || (! window.empty() && '\n' == window.back());
+}
+
+GzipIndex::Key::Key(const std::string & path, const std::string & description)
+    : description(description)
+{
+    struct stat st;
+    if (0 != ::stat(path.c_str(), &st))
+        throw std::runtime_error("Can't stat catalogue at " + path + ": " + std::strerror(errno));
+
+    size = st.st_size;
+    mtime = st.st_mtime;
+}
+
+const std::uint64_t GzipIndex::span;
+const std::size_t GzipIndex::window_size;
+
+GzipIndex::GzipIndex()
+    : current_(0)
+{
+}
+
+void GzipIndex::add_point(std::uint64_t in, std::uint64_t out, int bits, const unsigned char * window, std::size_t size)
+{
+    AccessPoint point;
+    point.out = out;
+    point.in = in;
+    point.bits = bits;
+    point.window.assign(window, window + size);
+    points_.push_back(std::move(point));
+}
+
+void GzipIndex::add_line(std::uint64_t offset, double ra, double dec)
+{
+    if (points_.empty())
+        return;
+
+    while (current_ + 1 < points_.size() && points_[current_ + 1].out <= offset)
+        ++current_;
+
+    points_[current_].bounds.add(ra, dec);
+}
+
+void GzipIndex::clear()
+{
+    points_.clear();
+    current_ = 0;
+}
+
+bool GzipIndex::read(const std::string & path, const Key & key)
+{
+    std::ifstream is(path, std::ios_base::binary);
+    if (! is)
+        return false;
+
+    char magic[sizeof(index_magic)];
+    if (! is.read(magic, sizeof(magic)) || 0 != std::memcmp(magic, index_magic, sizeof(magic)))
+        return false;
+
+    std::uint64_t size, s;
+    std::int64_t mtime;
+    std::uint32_t description_size;
+    if (! get(is, size) || ! get(is, mtime) || ! get(is, description_size))
+        return false;
+
+    std::string description(description_size, '\0');
+    if (! is.read(&description[0], description_size))
+        return false;
+
+    if (size != key.size || mtime != key.mtime || description != key.description)
+        return false;
+
+    std::uint32_t count;
+    if (! get(is, s) || s != span || ! get(is, count))
+        return false;
+
+    std::vector<AccessPoint> points(count);
+    for (auto & p : points)
+    {
+        std::int32_t bits;
+        std::uint32_t window;
+        if (! get(is, p.out) || ! get(is, p.in) || ! get(is, bits) || ! get(is, window) || ! get(is, p.bounds)
+            || window > window_size)
+            return false;
+
+        p.bits = bits;
+        p.window.resize(window);
+        if (! is.read(reinterpret_cast<char *>(p.window.data()), window))
+            return false;
+    }
+
+    points_ = std::move(points);
+    current_ = 0;
+    return true;
+}
+
+void GzipIndex::write(const std::string & path, const Key & key) const
+{
+    const std::string tmp(path + ".tmp");
+    {
+        std::ofstream os(tmp, std::ios_base::binary);
+        if (! os)
+            throw std::runtime_error("Can't open index '" + tmp + "' for writing: " + std::strerror(errno));
+
+        os.write(index_magic, sizeof(index_magic));
+        put(os, std::uint64_t(key.size));
+        put(os, std::int64_t(key.mtime));
+        put(os, std::uint32_t(key.description.size()));
+        os.write(key.description.data(), key.description.size());
+        put(os, std::uint64_t(span));
+        put(os, std::uint32_t(points_.size()));
+        for (auto const & p : points_)
+        {
+            put(os, p.out);
+            put(os, p.in);
+            put(os, std::int32_t(p.bits));
+            put(os, std::uint32_t(p.window.size()));
+            put(os, p.bounds);
+            os.write(reinterpret_cast<const char *>(p.window.data()), p.window.size());
+        }
+
+        if (! os.flush())
+            throw std::runtime_error("Writing index '" + tmp + "' failed");
+    }
+
+    if (0 != std::rename(tmp.c_str(), path.c_str()))
+        throw std::runtime_error("Can't move index to '" + path + "': " + std::strerror(errno));
+}
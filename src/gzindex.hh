@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_GZINDEX_HH
+#define ACHARTS_GZINDEX_HH 1
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Range of equatorial coordinates, in degrees, covered by a bunch of
+ * catalogue lines.
+ */
+struct SkyBox
+{
+    float ra_min, ra_max, dec_min, dec_max;
+
+    SkyBox();
+
+    bool empty() const;
+    void add(double ra, double dec);
+
+    // Conservative test against a spherical cap given in degrees.
+    bool intersects_cap(double ra, double dec, double radius) const;
+};
+
+/*
+ * zran-style access points into a gzip catalogue.  Every point holds
+ * enough state to start inflating in the middle of the file, and the
+ * extent of the sky covered by lines starting in its span, so that a
+ * chart of a small field inflates only the spans it needs.
+ */
+class GzipIndex
+{
+public:
+    static const std::uint64_t span{1024 * 1024};
+    static const std::size_t window_size{32768};
+
+    struct AccessPoint
+    {
+        std::uint64_t out;  // offset in uncompressed data
+        std::uint64_t in;   // offset of first full byte in compressed data
+        int bits;           // number of bits of the preceding byte
+        std::vector<unsigned char> window;
+        SkyBox bounds;
+
+        // Does out fall on the beginning of a line?
+        bool line_start() const;
+    };
+
+    // Identifies the catalogue an index was built from.
+    struct Key
+    {
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::string description;
+
+        Key(const std::string & path, const std::string & description);
+    };
+
+    GzipIndex();
+
+    // Used while inflating the whole file.
+    void add_point(std::uint64_t in, std::uint64_t out, int bits, const unsigned char * window, std::size_t size);
+    void add_line(std::uint64_t offset, double ra, double dec);
+    // Drops all points, for data that can't be indexed after all.
+    void clear();
+
+    // Returns false if there is no index at path, or it's stale.
+    bool read(const std::string & path, const Key & key);
+    void write(const std::string & path, const Key & key) const;
+
+    const std::vector<AccessPoint> & points() const { return points_; }
+
+private:
+    std::vector<AccessPoint> points_;
+    std::size_t current_;
+};
+
+#endif
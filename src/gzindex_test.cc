@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "catalogue.hh"
+#include "stars.hh"
+
+/*
+ * Loads a gzipped catalogue, several index spans long, through its
+ * index: as a whole, and just its last span, each twice.  Loads that
+ * use the index must see as many lines as the one building it, and
+ * the same stars, in the same order, as a load without the index.  The
+ * last span has to hold all stars around the pole, in order too.
+ * Bytes following the last gzip member must be ignored.
+ */
+
+namespace
+{
+
+const char * const path{"gzindex_test.dat.gz"};
+const int lines{40000};
+
+// Bright Star Catalogue layout, southern stars first.
+void write_catalogue()
+{
+    gzFile f(gzopen(path, "wb"));
+    if (! f)
+    {
+        std::cerr << "Can't write " << path << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    for (int i(0); i < lines; ++i)
+    {
+        const double dec(-89. + 178. * i / lines);
+        const int ra_s(i * 7919 % 86400), dec_s(int(std::abs(dec) * 3600.));
+        char line[112];
+        std::snprintf(line, sizeof line,
+                      "%4d%-10.10s%61s%02d%02d%04.1f%c%02d%02d%02d%12s%5.2f   \n",
+                      i % 10000, "Star", "",
+                      ra_s / 3600, ra_s / 60 % 60, double(ra_s % 60),
+                      dec < 0. ? '-' : '+', dec_s / 3600, dec_s / 60 % 60, dec_s % 60,
+                      "", 1. + i % 70 / 10.);
+        gzputs(f, line);
+    }
+    gzclose(f);
+}
+
+struct Record
+{
+    double ra, dec, mag;
+
+    bool operator==(const Record & rh) const
+    {
+        return ra == rh.ra && dec == rh.dec && mag == rh.mag;
+    }
+};
+
+typedef std::vector<Record> Records;
+
+// Returns the number of lines read, stars loaded going to records.
+std::size_t load(bool indexed, bool north_only, Records & records)
+{
+    Catalogue c;
+    c.path(path);
+    c.index(indexed);
+    if (north_only)
+        c.region(0., 90., 2.);
+    const std::size_t count(c.load());
+
+    records.clear();
+    for (ConstStarIterator i(c.begin_stars()); i != c.end_stars(); ++i)
+        records.push_back(Record{i->pos_.ra, i->pos_.dec, i->vmag_});
+    return count;
+}
+
+// Stars of records within 2 degrees of the pole, in order.
+Records polar(const Records & records)
+{
+    Records ret;
+    std::copy_if(records.begin(), records.end(), std::back_inserter(ret), [](const Record & r)
+                 {
+                     return r.dec >= 88.;
+                 });
+    return ret;
+}
+
+}
+
+int main()
+{
+    std::remove((std::string(path) + ".index").c_str());
+    write_catalogue();
+
+    int failures(0);
+    Records plain, built;
+    load(false, false, plain);
+    const std::size_t all(load(true, false, built));
+    if (lines != all)
+    {
+        std::cerr << "Building the index loaded " << all << " lines of " << lines << std::endl;
+        ++failures;
+    }
+    if (plain.size() != lines || built != plain)
+    {
+        std::cerr << "Building the index loaded " << built.size() << " stars, not the "
+                  << plain.size() << " of a load without it in the same order" << std::endl;
+        ++failures;
+    }
+
+    for (int pass(0); pass < 2; ++pass)
+    {
+        try
+        {
+            Records stars, north_stars;
+            const std::size_t indexed(load(true, false, stars)), north(load(true, true, north_stars));
+            if (indexed != all)
+            {
+                std::cerr << "Indexed load " << pass << " got " << indexed << " lines of " << all << std::endl;
+                ++failures;
+            }
+            if (stars != plain)
+            {
+                std::cerr << "Indexed load " << pass << " got " << stars.size() << " stars, not the "
+                          << plain.size() << " of a load without the index in the same order" << std::endl;
+                ++failures;
+            }
+            if (0 == north || north >= all)
+            {
+                std::cerr << "Indexed load " << pass << " of the last span got " << north << " lines" << std::endl;
+                ++failures;
+            }
+            if (polar(north_stars) != polar(plain))
+            {
+                std::cerr << "Indexed load " << pass << " of the last span got " << polar(north_stars).size()
+                          << " stars around the pole, not the " << polar(plain).size()
+                          << " of a load without the index in the same order" << std::endl;
+                ++failures;
+            }
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << "Indexed load " << pass << " failed: " << e.what() << std::endl;
+            ++failures;
+        }
+    }
+
+    // like gzip, loads ignore bytes following the last member
+    std::remove((std::string(path) + ".index").c_str());
+    if (std::FILE * f = std::fopen(path, "ab"))
+    {
+        const char trailing[] = "\0\0\0\0garbage";
+        std::fwrite(trailing, 1, sizeof trailing, f);
+        std::fclose(f);
+    }
+    const char * const trailed[] = {"without the index", "building the index", "using the index"};
+    for (int pass(0); pass < 3; ++pass)
+    {
+        try
+        {
+            Records stars;
+            load(0 != pass, false, stars);
+            if (stars != plain)
+            {
+                std::cerr << "Loading " << trailed[pass] << " with trailing garbage got " << stars.size()
+                          << " stars, not the " << plain.size() << " of a load without it" << std::endl;
+                ++failures;
+            }
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << "Loading " << trailed[pass] << " with trailing garbage failed: " << e.what() << std::endl;
+            ++failures;
+        }
+    }
+
+    std::remove((std::string(path) + ".index").c_str());
+    std::remove(path);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -22,63 +22,215 @@
  */
 #include "gzstream.hh"
 
-gzstreambuf::gzstreambuf(std::streambuf * sbuf)
-    : sbuf_(sbuf), input_(new char[buf_size]), output_(new char[buf_size])
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+GzipSource::GzipSource(std::unique_ptr<FileSource> file, std::unique_ptr<char[]> input, std::size_t pending)
+    : file_(std::move(file)), input_(std::move(input)), output_(new char[block_size]), finished_(false),
+      wrapped_(true), total_in_(0), total_out_(0), index_(nullptr), last_point_(0), window_pos_(0), window_full_(false)
+{
+    stream_.avail_in = pending;
+    stream_.next_in = (Bytef *) input_.get();
+    init_stream(31);
+}
+
+GzipSource::GzipSource(std::unique_ptr<FileSource> file, const GzipIndex::AccessPoint & point)
+    : file_(std::move(file)), input_(new char[block_size]), output_(new char[block_size]), finished_(false),
+      wrapped_(false), total_in_(point.in), total_out_(point.out), index_(nullptr), last_point_(0), window_pos_(0), window_full_(false)
+{
+    file_->seek(point.in - (point.bits ? 1 : 0));
+    stream_.avail_in = 0;
+    stream_.next_in = Z_NULL;
+    init_stream(-15);
+
+    if (point.bits)
+    {
+        unsigned char c;
+        if (1 != file_->read(reinterpret_cast<char *>(&c), 1))
+            throw gzstream_error("Unexpected end of compressed catalogue");
+        inflatePrime(&stream_, point.bits, c >> (8 - point.bits));
+    }
+    if (! point.window.empty())
+        inflateSetDictionary(&stream_, point.window.data(), point.window.size());
+}
+
+void GzipSource::init_stream(int window_bits)
 {
     stream_.zalloc = Z_NULL;
     stream_.zfree = Z_NULL;
     stream_.opaque = Z_NULL;
-    stream_.avail_in = 0;
     stream_.avail_out = 0;
-    stream_.next_in = Z_NULL;
     stream_.next_out = Z_NULL;
-    int r(inflateInit2(&stream_, 31));
+    int r(inflateInit2(&stream_, window_bits));
     if (Z_OK != r)
         throw gzstream_error(stream_.msg);
 }
 
-gzstreambuf::~gzstreambuf()
+GzipSource::~GzipSource()
 {
     inflateEnd(&stream_);
+}
 
-    delete [] input_;
-    delete [] output_;
+void GzipSource::build_index(GzipIndex * index)
+{
+    index_ = index;
+    window_.resize(GzipIndex::window_size);
 }
 
-gzstreambuf::int_type gzstreambuf::underflow()
+void GzipSource::remember(const unsigned char * data, std::size_t size)
 {
-    if (0 == stream_.avail_in)
+    if (size >= window_.size())
+    {
+        std::memcpy(window_.data(), data + size - window_.size(), window_.size());
+        window_pos_ = 0;
+        window_full_ = true;
+        return;
+    }
+
+    std::size_t first(std::min(size, window_.size() - window_pos_));
+    std::memcpy(window_.data() + window_pos_, data, first);
+    std::memcpy(window_.data(), data + first, size - first);
+    window_pos_ += size;
+    if (window_pos_ >= window_.size())
+    {
+        window_pos_ -= window_.size();
+        window_full_ = true;
+    }
+}
+
+void GzipSource::add_point()
+{
+    if (! window_full_)
     {
-        std::streamsize size{sbuf_->sgetn(input_, buf_size)};
-        if (0 == size)
-            return traits_type::eof();
+        index_->add_point(total_in_, total_out_, stream_.data_type & 7, window_.data(), window_pos_);
+        return;
+    }
+
+    std::vector<unsigned char> window(window_.size());
+    std::copy(window_.begin() + window_pos_, window_.end(), window.begin());
+    std::copy(window_.begin(), window_.begin() + window_pos_, window.end() - window_pos_);
+    index_->add_point(total_in_, total_out_, stream_.data_type & 7, window.data(), window.size());
+}
 
+bool GzipSource::seekable() const
+{
+    return file_->seekable();
+}
+
+bool GzipSource::more_input()
+{
+    if (0 == stream_.avail_in)
+    {
+        std::size_t size(file_->read(input_.get(), block_size));
         stream_.avail_in = size;
-        stream_.next_in = (Bytef *) input_;
+        stream_.next_in = (Bytef *) input_.get();
+    }
+    return 0 != stream_.avail_in;
+}
+
+void GzipSource::skip_input(std::size_t size)
+{
+    while (0 != size && more_input())
+    {
+        const std::size_t skipped(std::min<std::size_t>(size, stream_.avail_in));
+        stream_.next_in += skipped;
+        stream_.avail_in -= skipped;
+        total_in_ += skipped;
+        size -= skipped;
     }
+}
 
-    if (0 == egptr() - gptr())
+bool GzipSource::member_follows()
+{
+    // the magic may be split between two reads
+    if (1 == stream_.avail_in)
     {
-        stream_.avail_out = buf_size;
-        stream_.next_out = (Bytef *) output_;
+        input_[0] = *stream_.next_in;
+        stream_.next_in = (Bytef *) input_.get();
+        stream_.avail_in += file_->read(input_.get() + 1, block_size - 1);
     }
+    if (! more_input())
+        return false;
+    if (stream_.avail_in >= 2 && 0x1f == stream_.next_in[0] && 0x8b == stream_.next_in[1])
+        return true;
 
-    if (0 != stream_.avail_out)
+    // Like gzip, ignore what follows the last member, silently if it's
+    // only zeros padding the file.
+    bool garbage(false);
+    do
     {
-        int ret{inflate(&stream_, Z_NO_FLUSH)};
-        assert(Z_STREAM_ERROR != ret);
+        garbage = garbage || stream_.next_in + stream_.avail_in !=
+            std::find_if(stream_.next_in, stream_.next_in + stream_.avail_in, [](Bytef b) { return 0 != b; });
+        total_in_ += stream_.avail_in;
+        stream_.avail_in = 0;
+    }
+    while (more_input());
+    if (garbage)
+        std::cerr << "Warning: ignoring trailing garbage after compressed catalogue" << std::endl;
+    return false;
+}
+
+std::size_t GzipSource::next_block(const char *& data)
+{
+    stream_.avail_out = block_size;
+    stream_.next_out = (Bytef *) output_.get();
+
+    while (! finished_ && 0 != stream_.avail_out)
+    {
+        if (! more_input())
+            throw gzstream_error("Unexpected end of compressed catalogue");
+
+        // Z_BLOCK stops at deflate block boundaries, which are the only
+        // places an access point can be taken at
+        Bytef * before_out(stream_.next_out);
+        uInt before_in(stream_.avail_in);
+        int ret{inflate(&stream_, index_ ? Z_BLOCK : Z_NO_FLUSH)};
         switch (ret)
         {
+            case Z_STREAM_END:
+                finished_ = true;
+                break;
             case Z_NEED_DICT:
-                ret = Z_DATA_ERROR;
-                // keep going
             case Z_DATA_ERROR:
             case Z_MEM_ERROR:
-                return traits_type::eof();
+            case Z_STREAM_ERROR:
+                throw gzstream_error(stream_.msg ? stream_.msg : "Inflating catalogue failed");
+        }
+        total_in_ += before_in - stream_.avail_in;
+        total_out_ += stream_.next_out - before_out;
+
+        if (index_)
+        {
+            remember(before_out, stream_.next_out - before_out);
+            if ((stream_.data_type & 128) && ! (stream_.data_type & 64) &&
+                (0 == total_out_ || total_out_ - last_point_ >= GzipIndex::span))
+            {
+                add_point();
+                last_point_ = total_out_;
+            }
+        }
+
+        // raw deflate ends before the member's trailer, CRC and size
+        if (finished_ && ! wrapped_)
+            skip_input(8);
+
+        if (finished_ && member_follows())
+        {
+            // another member follows; access points can't restart
+            // inflating across a gzip header, so give up on indexing
+            if (index_)
+            {
+                index_->clear();
+                index_ = nullptr;
+            }
+            finished_ = false;
+            wrapped_ = true;
+            if (Z_OK != inflateReset2(&stream_, 31))
+                throw gzstream_error(stream_.msg ? stream_.msg : "Inflating catalogue failed");
         }
     }
 
-    std::streamsize have{buf_size - stream_.avail_out};
-    setg(output_, output_, output_ + have);
-    return traits_type::to_int_type(*gptr());
+    data = output_.get();
+    return block_size - stream_.avail_out;
 }
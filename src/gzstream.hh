@@ -23,13 +23,14 @@
 #ifndef ACHARTS_GZSTREAMBUF_HH
 #define ACHARTS_GZSTREAMBUF_HH 1
 
-#include <cassert>
-#include <streambuf>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 #include <zlib.h>
 
-#include <iostream>
-#include <fstream>
-#include <stdexcept>
+#include "file_source.hh"
+#include "gzindex.hh"
 
 class gzstream_error
     : public std::runtime_error
@@ -41,39 +42,55 @@ public:
     }
 };
 
-class gzstreambuf
-    : public std::streambuf
+/*
+ * Inflates gzip data read from a FileSource into our own output buffer.
+ * Concatenated gzip members, as written by e.g. pigz or `cat a.gz b.gz`,
+ * are inflated one after another.
+ */
+class GzipSource
+    : public BlockSource
 {
-    static const std::streamsize buf_size{128 * 1024};
-
-    std::streambuf * sbuf_;
+    std::unique_ptr<FileSource> file_;
     z_stream stream_;
-    char * input_;
-    char * output_;
+    std::unique_ptr<char[]> input_;
+    std::unique_ptr<char[]> output_;
+    bool finished_;
+    // whether zlib parses gzip headers and trailers, which it doesn't
+    // when resuming raw deflate data at an access point
+    bool wrapped_;
+
+    std::uint64_t total_in_, total_out_;
+    GzipIndex * index_;
+    std::uint64_t last_point_;
+    std::vector<unsigned char> window_;
+    std::size_t window_pos_;
+    bool window_full_;
+
 public:
-    explicit gzstreambuf(std::streambuf * sbuf);
-    gzstreambuf(const gzstreambuf &) = delete;
-    gzstreambuf(gzstreambuf &&) = delete;
+    // input holds pending compressed bytes already read from file.
+    GzipSource(std::unique_ptr<FileSource> file, std::unique_ptr<char[]> input, std::size_t pending);
+    // Resumes inflating at an access point of an index.
+    GzipSource(std::unique_ptr<FileSource> file, const GzipIndex::AccessPoint & point);
+    GzipSource(const GzipSource &) = delete;
+    GzipSource(GzipSource &&) = delete;
 
-    ~gzstreambuf();
+    ~GzipSource();
 
-    int_type underflow() override;
-};
+    // Records access points into index as the data gets inflated.  Has
+    // to be called before the first block is requested.
+    void build_index(GzipIndex * index);
 
-class igzfstream
-    : public std::istream
-{
-private:
-    std::filebuf filebuf_;
-    gzstreambuf gzstreambuf_;
+    bool seekable() const;
 
-public:
-    igzfstream(const char * path)
-        : std::istream(), filebuf_(), gzstreambuf_(&filebuf_)
-    {
-        filebuf_.open(path, std::ios_base::in);
-        this->init(&gzstreambuf_);
-    }
+    std::size_t next_block(const char *& data) override;
+
+private:
+    bool more_input();
+    bool member_follows();
+    void skip_input(std::size_t size);
+    void init_stream(int window_bits);
+    void remember(const unsigned char * data, std::size_t size);
+    void add_point();
 };
 
 #endif
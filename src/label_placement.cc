@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "label_placement.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "canvas_grid.hh"
+
+LabelPlacement::LabelPlacement(const CanvasBox & area, double size)
+    : area_(area),
+      size_(size)
+{
+}
+
+double LabelPlacement::width(const std::string & text) const
+{
+    // characters of sans-serif fonts are around 0.6 of their height
+    // wide; continuation bytes of UTF-8 don't count
+    const std::size_t characters(std::count_if(text.begin(), text.end(), [](char c)
+                                               {
+                                                   return 0x80 != (static_cast<unsigned char>(c) & 0xc0);
+                                               }));
+    return 0.6 * size_ * characters;
+}
+
+void LabelPlacement::obstacle(const CanvasPoint & pos, const std::string & text)
+{
+    obstacles_.push_back(CanvasBox{CanvasPoint(pos.x, pos.y - size_), CanvasPoint(pos.x + width(text), pos.y)});
+}
+
+void LabelPlacement::add(const void * key, const CanvasPoint & pos, double radius,
+                         const std::string & label, double priority)
+{
+    if (! label.empty())
+        candidates_.push_back(Candidate{key, pos, radius, width(label), priority});
+}
+
+void LabelPlacement::place(const Covers & covers)
+{
+    std::stable_sort(candidates_.begin(), candidates_.end(), [](const Candidate & l, const Candidate & r)
+                     {
+                         return l.priority < r.priority;
+                     });
+
+    const std::size_t count(obstacles_.size() + candidates_.size());
+    labels_.reserve(labels_.size() + candidates_.size());
+    CanvasGrid grid(area_, std::max(CanvasGrid::cell_for(area_, count), 2. * size_));
+    for (const CanvasBox & box : obstacles_)
+        grid.insert(box);
+
+    // boxes are shrunk by gap for checking, so that labels may touch
+    // their own symbols, and overlap the edges of others a little
+    const double gap(0.1 * size_), half(size_ / 2.), diagonal(std::sqrt(0.5));
+    for (const Candidate & c : candidates_)
+    {
+        const double r(c.radius), d(r * diagonal);
+        const Label tries[]{
+            {CanvasPoint(c.pos.x + r, c.pos.y), Anchor::Start},
+            {CanvasPoint(c.pos.x - r, c.pos.y), Anchor::End},
+            {CanvasPoint(c.pos.x, c.pos.y - r - half), Anchor::Middle},
+            {CanvasPoint(c.pos.x, c.pos.y + r + half), Anchor::Middle},
+            {CanvasPoint(c.pos.x + d, c.pos.y - d - half), Anchor::Start},
+            {CanvasPoint(c.pos.x + d, c.pos.y + d + half), Anchor::Start},
+            {CanvasPoint(c.pos.x - d, c.pos.y - d - half), Anchor::End},
+            {CanvasPoint(c.pos.x - d, c.pos.y + d + half), Anchor::End}};
+
+        for (const Label & l : tries)
+        {
+            const double start(Anchor::Start == l.anchor ? l.at.x
+                               : Anchor::Middle == l.anchor ? l.at.x - c.width / 2.
+                               : l.at.x - c.width);
+            const CanvasBox box{CanvasPoint(start, l.at.y - half), CanvasPoint(start + c.width, l.at.y + half)};
+            const CanvasBox clear{CanvasPoint(box.start.x + gap, box.start.y + gap),
+                                  CanvasPoint(box.end.x - gap, box.end.y - gap)};
+            if (! grid.any(clear) && ! covers(clear))
+            {
+                grid.insert(box);
+                labels_[c.key] = Label{l.at - c.pos, l.anchor};
+                break;
+            }
+        }
+    }
+
+    obstacles_.clear();
+    candidates_.clear();
+}
+
+bool LabelPlacement::find(const void * key, Label & label) const
+{
+    const auto i(labels_.find(key));
+    if (labels_.end() == i)
+        return false;
+    label = i->second;
+    return true;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_LABEL_PLACEMENT_HH
+#define ACHARTS_LABEL_PLACEMENT_HH 1
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "canvas.hh"
+
+/*
+ * Places labels of symbols so that they cover neither each other, nor
+ * symbols, nor texts.  Each label is tried right of its symbol, where
+ * it has always been drawn, then left, above, below and on the
+ * diagonals, and dropped if none of these is free.  Labels of higher
+ * priority go first.  Placed labels and texts are kept in a grid of
+ * cells a few labels wide, so trying a position looks at its
+ * neighbours only, and symbols are left to the caller to look up
+ * likewise.  Placing n labels takes O(n log n) for sorting them.
+ * Sizes of labels are estimated from their height, and their number
+ * of characters.
+ */
+class LabelPlacement
+{
+public:
+    enum class Anchor
+    {
+        Start,
+        Middle,
+        End
+    };
+
+    // Text drawn at at, relative to its symbol, centred vertically, and
+    // aligned by anchor.
+    struct Label
+    {
+        CanvasPoint at;
+        Anchor anchor;
+    };
+
+    // Labels of height size, on a canvas of area.
+    LabelPlacement(const CanvasBox & area, double size);
+
+    // Text with baseline at pos, and that no label may overlap either.
+    void obstacle(const CanvasPoint & pos, const std::string & text);
+    // Label of symbol of radius at pos, identified by key.  Labels of
+    // lower priority values are placed earlier.
+    void add(const void * key, const CanvasPoint & pos, double radius,
+             const std::string & label, double priority);
+
+    // Whether a label covering box would hide a symbol.
+    typedef std::function<bool (const CanvasBox & box)> Covers;
+
+    // Places labels added so far, off symbols as told by covers.
+    void place(const Covers & covers);
+
+    // Where the label of key goes, or false if it's dropped.
+    bool find(const void * key, Label & label) const;
+
+private:
+    struct Candidate
+    {
+        const void * key;
+        CanvasPoint pos;
+        double radius, width, priority;
+    };
+
+    double width(const std::string & text) const;
+
+    CanvasBox area_;
+    double size_;
+    std::vector<CanvasBox> obstacles_;
+    std::vector<Candidate> candidates_;
+    std::unordered_map<const void *, Label> labels_;
+};
+
+#endif
@@ -22,8 +22,12 @@
  */
 #include "magic.hh"
 
-#include <fstream>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 
+#include "file_source.hh"
 #include "gzstream.hh"
 
 namespace
@@ -33,17 +37,24 @@ const std::array<char, 2> gzip_magic = {{ 0x1f, char(0x8b) }};
 
 }
 
-std::unique_ptr<std::istream> open_file_with_magic(const char * path)
+std::unique_ptr<BlockSource> open_file_with_magic(const char * path)
 {
-    std::array<char, 2> signature;
-    std::ifstream f(path);
-    if (2 != f.rdbuf()->sgetn(&signature[0], 2))
-        throw std::runtime_error(std::string("Can't open catalogue at ") + path);
-
-    if (gzip_magic == signature)
+    std::unique_ptr<FileSource> file(new FileSource(path));
+    std::unique_ptr<char[]> buffer(new char[BlockSource::block_size]);
+    // a pipe may hand out fewer bytes than are needed to tell the format
+    std::size_t size(0);
+    while (size < gzip_magic.size())
     {
-        return std::unique_ptr<std::istream>(new igzfstream(path));
+        std::size_t r(file->read(buffer.get() + size, BlockSource::block_size - size));
+        if (0 == r)
+            break;
+        size += r;
     }
+    if (size < gzip_magic.size())
+        throw std::runtime_error(std::string("Can't open catalogue at ") + path);
+
+    if (0 == std::memcmp(buffer.get(), gzip_magic.data(), gzip_magic.size()))
+        return std::unique_ptr<BlockSource>(new GzipSource(std::move(file), std::move(buffer), size));
 
-    return std::unique_ptr<std::istream>(new std::ifstream(path));
+    return std::unique_ptr<BlockSource>(new PlainSource(std::move(file), std::move(buffer), size));
 }
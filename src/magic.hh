@@ -23,9 +23,13 @@
 #ifndef ACHARTS_MAGIC_HH
 #define ACHARTS_MAGIC_HH 1
 
-#include <iosfwd>
 #include <memory>
 
-std::unique_ptr<std::istream> open_file_with_magic(const char * path);
+class BlockSource;
+
+// Opens path once and picks a decoder based on the first bytes read.
+// The data is then decoded in a single pass, so path may well be "-"
+// or a pipe.
+std::unique_ptr<BlockSource> open_file_with_magic(const char * path);
 
 #endif
@@ -20,196 +20,441 @@
  * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <libnova/libnova.h>
 #include <deque>
 #include <fstream>
+#include <future>
+#include <iterator>
 #include <iostream>
+#include <map>
 #include <sstream>
 
 #include "config.hh"
 #include "drawer.hh"
 #include "exceptions.hh"
+#include "precession.hh"
 #include "projection.hh"
 #include "scene.hh"
 #include "solar_object.hh"
 #include "stars.hh"
 #include "svg_painter.hh"
+#include "task_pool.hh"
 #include "types.hh"
 
-int main(int arc, char * arv[])
+namespace
 {
-    try
+
+// What a view draws, in the order of painting.
+enum class Layer
+{
+    Background,
+    Catalogues,
+    SolarSystem,
+    Tracks,
+    Constellations,
+    Grids,
+    Ticks,
+    Count
+};
+
+// Part of the canvas showing the sky through a projection of its own:
+// the main chart, or an inset at position.
+struct View
+{
+    std::string id;
+    CanvasPoint position, size;
+    std::shared_ptr<Projection> projection;
+    // everything outside of it gets rejected before projection
+    SkyCap region;
+    // and everything projected outside of this, as it gets drawn
+    CanvasBox clip;
+    // lists being built for each layer, most of them a single group
+    std::array<std::deque<std::future<scene::DisplayList>>, static_cast<std::size_t>(Layer::Count)> layers;
+
+    std::deque<std::future<scene::DisplayList>> & layer(Layer l)
     {
-        std::cout << "Processing configs... " << std::flush;
-        Config config(arc, arv);
-        std::cout << "done." << std::endl;
+        return layers[static_cast<std::size_t>(l)];
+    }
+};
 
-        ln_lnlat_posn observer(config.location());
-        const double t(config.t());
-        const double global_epoch(config.epoch());
+// Future of a list there is nothing more to do with.
+std::future<scene::DisplayList> ready(scene::DisplayList && list)
+{
+    std::promise<scene::DisplayList> promise;
+    promise.set_value(std::move(list));
+    return promise.get_future();
+}
 
-        CanvasPoint canvas(config.canvas_dimensions());
-        ln_equ_posn apparent_canvas(config.projection_dimensions()),
-            center(config.projection_centre());
+std::shared_ptr<Projection> create_projection(const Config & config, const std::string & type,
+                                              const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                                              ln_equ_posn center, const std::string & level,
+                                              ln_lnlat_posn observer, double t)
+{
+    std::shared_ptr<Projection> projection(ProjectionFactory::create(type, canvas, apparent_canvas, center));
 
-        std::shared_ptr<Projection> projection(ProjectionFactory::create(config.projection_type(),
-                                                                         canvas, apparent_canvas, center));
+    if (level == "horizon")
+    {
+        ln_hrz_posn hor;
+        ln_get_hrz_from_equ(&center, &observer, t, &hor);
+        ln_hrz_posn hor2(hor);
+        hor.az -= 1.0;
+        hor2.az += 1.0;
+        ln_equ_posn equ, equ2;
+        ln_get_equ_from_hrz(&hor, &observer, t, &equ);
+        ln_get_equ_from_hrz(&hor2, &observer, t, &equ2);
 
-        if (config.projection_level() == "horizon")
-        {
-            ln_hrz_posn hor;
-            ln_get_hrz_from_equ(&center, &observer, t, &hor);
-            ln_hrz_posn hor2(hor);
-            hor.az -= 1.0;
-            hor2.az += 1.0;
-            ln_equ_posn equ, equ2;
-            ln_get_equ_from_hrz(&hor, &observer, t, &equ);
-            ln_get_equ_from_hrz(&hor2, &observer, t, &equ2);
 
+        projection->rotate_to_level(equ, equ2);
+    }
+    else if (level == "ecliptic")
+    {
+        ln_lnlat_posn ecl;
+        ln_get_ecl_from_equ(&center, t, &ecl);
+        ln_lnlat_posn ecl2(ecl);
+        ecl.lng += 1.0;
+        ecl2.lng -= 1.0;
+        ln_equ_posn equ, equ2;
+        ln_get_equ_from_ecl(&ecl, t, &equ);
+        ln_get_equ_from_ecl(&ecl2, t, &equ2);
 
-            projection->rotate_to_level(equ, equ2);
-        }
-        else if (config.projection_level() == "ecliptic")
-        {
-            ln_lnlat_posn ecl;
-            ln_get_ecl_from_equ(&center, t, &ecl);
-            ln_lnlat_posn ecl2(ecl);
-            ecl.lng += 1.0;
-            ecl2.lng -= 1.0;
-            ln_equ_posn equ, equ2;
-            ln_get_equ_from_ecl(&ecl, t, &equ);
-            ln_get_equ_from_ecl(&ecl2, t, &equ2);
-
-            projection->rotate_to_level(equ, equ2);
-        }
+        projection->rotate_to_level(equ, equ2);
+    }
 
-        std::string style;
-        if (! config.stylesheet().empty())
-        {
-            std::ifstream f(config.stylesheet());
-            if (! f)
-                throw ConfigError("Stylesheet '" + config.stylesheet() + "' couldn't be opened.");
+    if (config.projection_precision() == "auto")
+        projection->choose_precision(config.projection_tolerance());
+    else if (config.projection_precision() != "double")
+        throw ConfigError("Unknown projection precision: " + config.projection_precision());
+    projection->choose_small_field(config.projection_tolerance());
 
-            std::stringstream buf;
-            buf << f.rdbuf();
-            style = buf.str();
-        }
+    return projection;
+}
 
-        scene::Scene scn(projection);
+// Culls and projects stars of a loaded catalogue, frame rotating them
+// into the chart's epoch.
+scene::DisplayList project_catalogue(const Catalogue & c, const View & view, const RotationMatrix & frame,
+                                     Arena & arena)
+{
+    const SkyCap local{frame.transposed() * view.region.centre, view.region.min_cos};
 
-        {
-            scene::Group gr{"rectangle", "background", {}};
-            gr.elements.push_back(scene::Rectangle{CanvasPoint(-canvas.x / 2., -canvas.y / 2.),
-                        CanvasPoint(canvas.x, canvas.y)});
-            scn.add_group(std::move(gr));
-        }
+    std::vector<const Star *> visible;
+    for (auto s(c.begin_stars()), s_end(c.end_stars()) ; s != s_end ; ++s)
+    {
+        if (local.contains(s->vec_))
+            visible.push_back(&*s);
+    }
 
-        std::cout << "Loading catalogues... " << std::flush;
-        for (auto & c : config.view<Catalogue>())
-        {
-            const double epoch(c.epoch());
-            std::cout << c.path() << "(" << epoch << ") " << std::flush;
-            std::size_t count{c.load()};
-            std::cout << "{" << count << "}, " << std::flush;
+    std::vector<CanvasPoint> projected(visible.size());
+    view.projection->project_range(visible.begin(), visible.end(), frame,
+                                   [](const Star * s) { return s->vec_; }, projected.data());
 
-            std::deque<scene::Element> objs;
-            for (auto s(c.begin_stars()), s_end(c.end_stars()) ; s != s_end ; ++s)
-            {
-                objs.push_back(scene::Object{projection->project(convert_epoch(s->pos_, epoch, global_epoch)), s->vmag_});
-            }
-            scn.add_group(scene::Group{"catalog", c.path(), std::move(objs)});
-        }
-        std::cout << "done." << std::endl;
+    scene::DisplayList group(&arena, view.clip);
+    // "-" isn't a valid XML id
+    group.begin(scene::Group{"catalog", "-" == c.path() ? "catalogue-stdin" : c.path()});
+    auto p(projected.begin());
+    for (auto s : visible)
+    {
+        group.add(scene::Object{*p++, s->vmag_});
+    }
+    group.end();
+    return group;
+}
+
+// Counts ids of groups and insets, as SvgPainter names them.
+class IdCounter
+{
+    // innermost inset being painted, if any, and those around
+    std::vector<std::string> insets_;
+
+public:
+    std::map<std::string, std::size_t> ids;
+    std::vector<std::string> inset_ids;
+
+    IdCounter()
+        : insets_(1)
+    {
+    }
+
+    bool begin(const scene::Group & g)
+    {
+        insets_.push_back(insets_.back());
+        if (! g.id.empty())
+            ++ids[insets_.back().empty() ? g.id : inset_group_id(insets_.back(), g.id)];
+        return true;
+    }
+
+    void begin(const scene::Inset & i)
+    {
+        insets_.push_back(i.id);
+        inset_ids.push_back(i.id);
+        ++ids[i.id];
+        ++ids[i.id + "_clip"];
+    }
+
+    void end()
+    {
+        insets_.pop_back();
+    }
+
+    template <typename T>
+    void operator()(const T &)
+    {
+    }
+};
+
+// Viewports' names end up as ids of their insets and clip paths, which
+// have to be unique in the document.
+void check_viewport_names(const scene::Scene & scn)
+{
+    IdCounter counter;
+    scn.paint(counter);
+    for (auto const & id : counter.inset_ids)
+    {
+        if (counter.ids[id] > 1 || counter.ids[id + "_clip"] > 1)
+            throw ConfigError("Viewport name '" + id + "' is used twice, or by another part of the chart.");
+    }
+}
+
+// Builds every view, drawing everything from arena, and adds them
+// to scn.
+void build_scene(const Config & config, scene::Scene & scn, Arena & arena)
+{
+    ln_lnlat_posn observer(config.location());
+    const double t(config.t());
+    const double global_epoch(config.epoch());
+
+    CanvasPoint canvas(config.canvas_dimensions());
 
-        std::cout << "Loading solar objects..." << std::flush;
-        SolarObjectManager solar_manager;
+    std::deque<View> views;
+    views.push_back(View{"", CanvasPoint(), canvas,
+                create_projection(config, config.projection_type(), canvas, config.projection_dimensions(),
+                                  config.projection_centre(), config.projection_level(), observer, t),
+                SkyCap::whole_sky(), CanvasBox::around(canvas, config.canvas_margin()), {}});
+    for (auto const & v : config.view<Viewport>())
+    {
+        const std::string id(v.name.empty() ? "viewport" + std::to_string(views.size()) : v.name);
+        views.push_back(View{id, v.position, v.size,
+                    create_projection(config, v.type, v.size, v.dimensions, v.centre, v.level, observer, t),
+                    SkyCap::whole_sky(), CanvasBox::around(v.size, config.canvas_margin()), {}});
+    }
+
+    for (auto & view : views)
+    {
+        view.region = view.projection->visible_region(config.canvas_margin());
 
+        scene::DisplayList gr(&arena);
+        gr.begin(scene::Group{"rectangle", "background"});
+        gr.add(scene::Rectangle{CanvasPoint(-view.size.x / 2., -view.size.y / 2.), view.size});
+        gr.end();
+        view.layer(Layer::Background).push_back(ready(std::move(gr)));
+    }
+
+    SolarObjectManager solar_manager;
+    const std::vector<std::string> planet_names(config.planets());
+
+    // Layers only read the projections, so each of them is a task of
+    // its own, for every view.  They start right away and run along
+    // the catalogues loading.  Everything they use has to outlive the
+    // pool.
+    TaskPool pool;
+
+    for (auto & view : views)
+    {
+        const std::shared_ptr<Projection> projection(view.projection);
+        const SkyCap region(view.region);
+        const CanvasBox clip(view.clip);
+
+        view.layer(Layer::SolarSystem).push_back(pool.submit([&, projection, clip]()
         {
-            std::deque<std::shared_ptr<const SolarObject>> planets;
-            auto planet_names(config.planets());
+            std::vector<std::shared_ptr<const SolarObject>> planets;
+            std::vector<ln_equ_posn> positions;
             for (auto const & p : planet_names)
             {
                 planets.push_back(solar_manager.get(p));
+                positions.push_back(planets.back()->get_equ_coords(t));
             }
+            auto projected(projection->project_many(positions, precession_matrix(JD2000, global_epoch)));
 
-            std::deque<scene::Element> objs;
+            scene::DisplayList objs(&arena, clip);
+            objs.begin(scene::Group{"solar_system", "planets"});
+            auto p(projected.begin());
             for (auto const & planet : planets)
             {
-                objs.push_back(
-                    scene::LabelledObject{
-                        projection->project(convert_epoch(planet->get_equ_coords(t), JD2000, global_epoch)), planet->get_magnitude(t),
-                            planet->name()});
+                objs.add(
+                    scene::LabelledObject{*p++, planet->get_magnitude(t), planet->name()});
             }
-            scn.add_group(scene::Group{"solar_system", "planets", std::move(objs)});
-        }
+            objs.end();
+            return objs;
+        }));
 
+        auto proportional([&, projection, clip](const std::string & name)
+        {
+            return pool.submit([&, projection, clip, name]()
+            {
+                auto const & object(*solar_manager.get(name));
+                auto pos(convert_epoch(object.get_equ_coords(t), JD2000, global_epoch));
+                scene::DisplayList obj(&arena, clip);
+                obj.begin(scene::Group{"solar_system", name});
+                obj.add(scene::ProportionalObject{projection->project(pos),
+                            object.get_sdiam(t) * projection->scale_at_point(pos) / 3600.,
+                            object.name()});
+                obj.end();
+                return obj;
+            });
+        });
         if (config.moon())
+            view.layer(Layer::SolarSystem).push_back(proportional("moon"));
+        if (config.sun())
+            view.layer(Layer::SolarSystem).push_back(proportional("sun"));
+
+        for (auto const & track : config.view<Track>())
         {
-            auto const & moon(*solar_manager.get("moon"));
-            std::deque<scene::Element> obj;
-            auto pos(moon.get_equ_coords(t));
-            obj.push_back(scene::ProportionalObject{projection->project(convert_epoch(pos, JD2000, global_epoch)),
-                        moon.get_sdiam(t) * projection->scale_at_point(pos) / 3600.,
-                        moon.name()});
-            scn.add_group(scene::Group{"solar_system", "moon",
-                        std::move(obj)
-                        });
+            view.layer(Layer::Tracks).push_back(pool.submit([&, projection, region, clip, track]()
+            {
+                return scene::build_track(track, projection, region, clip, global_epoch, solar_manager, arena);
+            }));
         }
 
-        if (config.sun())
+        if (config.constellations())
         {
-            auto const & sun(*solar_manager.get("sun"));
-            std::deque<scene::Element> obj;
-            auto pos(sun.get_equ_coords(t));
-            obj.push_back(scene::ProportionalObject{projection->project(convert_epoch(pos, JD2000, global_epoch)),
-                        sun.get_sdiam(t) * projection->scale_at_point(pos) / 3600.,
-                        sun.name()});
-            scn.add_group(scene::Group{"solar_system", "sun",
-                        std::move(obj)
-                        });
+            view.layer(Layer::Constellations).push_back(pool.submit([&, projection, region, clip]()
+            {
+                return scene::build_constellations(projection, region, clip, global_epoch, arena);
+            }));
         }
-        std::cout << "done." << std::endl;
 
+        for (auto const & grid : config.view<Grid>())
         {
-            std::cout << "Drawing tracks... " << std::flush;
-            scene::Group tracks{"tracks", "track_container", {}};
-            for (auto const & track : config.view<Track>())
+            view.layer(Layer::Grids).push_back(pool.submit([&, projection, region, clip, grid]()
             {
-                std::cout << track.name << " " << std::flush;
-                tracks.elements.push_back(scene::build_track(track, projection, global_epoch, solar_manager));
-            }
-            scn.add_group(std::move(tracks));
-            std::cout << "done." << std::endl;
+                return scene::build_grid(grid, projection, region, clip, observer, t, arena);
+            }));
         }
 
-        if (config.constellations())
+        for (auto const & tick : config.view<Tick>())
         {
-            std::cout << "Drawing constellations... " << std::flush;
-            scn.add_group(scene::build_constellations(projection, global_epoch));
-            std::cout << "done." << std::endl;
+            view.layer(Layer::Ticks).push_back(pool.submit([&, projection, clip, tick]()
+            {
+                return scene::build_tick(tick, projection, clip, observer, t, arena);
+            }));
         }
+    }
+
+    // Catalogues get loaded once for all views, then every view culls
+    // and projects them in a task of its own.
+    SkyCap region(views.front().region);
+    for (auto const & view : views)
+        region = enclosing(region, view.region);
 
-        std::cout << "Drawing grids... " << std::flush;
-        for (auto grid : config.view<Grid>())
+    std::cout << "Loading catalogues... " << std::flush;
+    for (auto & c : config.view<Catalogue>())
+    {
+        const double epoch(c.epoch());
+        std::cout << c.path() << "(" << epoch << ") " << std::flush;
+        const RotationMatrix frame(precession_matrix(epoch, global_epoch));
+        // region in the catalogue's epoch
+        const SkyCap local{frame.transposed() * region.centre, region.min_cos};
+        const ln_equ_posn centre(local.centre.equ());
+        c.region(centre.ra, centre.dec, local.radius());
+        std::size_t count{c.load()};
+        std::cout << "{" << count << "}, " << std::flush;
+
+        for (auto & view : views)
         {
-            scn.add_group(scene::build_grid(grid, projection, observer, t));
+            view.layer(Layer::Catalogues).push_back(pool.submit([&c, &view, frame, &arena]()
+            {
+                return project_catalogue(c, view, frame, arena);
+            }));
         }
-        std::cout << "done." << std::endl;
+    }
+    std::cout << "done." << std::endl;
 
-        std::cout << "Drawing ticks... " << std::flush;
-        for (auto tick : config.view<Tick>())
+    std::cout << "Drawing... " << std::flush;
+    for (auto view(views.begin()); view != views.end(); ++view)
+    {
+        scene::DisplayList inset(&arena);
+        if (view != views.begin())
+            inset.begin(scene::Inset{view->id, view->position, view->size});
+        for (std::size_t l(0); l < view->layers.size(); ++l)
         {
-            scn.add_group(scene::build_tick(tick, projection, observer, t));
+            // tracks get a group around them all
+            const bool tracks(static_cast<std::size_t>(Layer::Tracks) == l);
+            if (tracks)
+                inset.begin(scene::Group{"tracks", "track_container"});
+            for (auto & part : view->layers[l])
+                inset.append(part.get());
+            if (tracks)
+                inset.end();
         }
+        if (view != views.begin())
+            inset.end();
+        scn.add(std::move(inset));
+    }
+    std::cout << "done, " << arena.allocations() << " allocations from " << arena.blocks() << " blocks."
+              << std::endl;
+
+    check_viewport_names(scn);
+}
+
+}
+
+int main(int arc, char * arv[])
+{
+    try
+    {
+        std::cout << "Processing configs... " << std::flush;
+        Config config(arc, arv);
         std::cout << "done." << std::endl;
 
+        std::string style;
+        if (! config.stylesheet().empty())
+        {
+            std::ifstream f(config.stylesheet());
+            if (! f)
+                throw ConfigError("Stylesheet '" + config.stylesheet() + "' couldn't be opened.");
+
+            std::stringstream buf;
+            buf << f.rdbuf();
+            style = buf.str();
+        }
+
+        CanvasPoint canvas(config.canvas_dimensions());
+
+        // everything drawn is allocated from it, and released at once
+        Arena arena;
+        scene::Scene scn(arena);
+
+        // only canvas margin may differ from the cached scene's, as long
+        // as it's not any wider
+        const std::string cache(config.scene_cache()), key(config.geometry_key());
+        if (! cache.empty() && ! key.empty() && scn.read(cache, key, config.canvas_margin()))
+            std::cout << "Scene read from " << cache << "." << std::endl;
+        else
+        {
+            build_scene(config, scn, arena);
+            if (! cache.empty() && ! key.empty())
+            {
+                try
+                {
+                    scn.write(cache, key, config.canvas_margin());
+                }
+                catch (const std::runtime_error & e)
+                {
+                    std::cerr << "Warning: " << e.what() << std::endl;
+                }
+            }
+        }
+
         std::ofstream of(config.output().c_str());
         if (! of)
             throw std::runtime_error("Can't open file '" + config.output() + "' for writing " + std::strerror(errno));
 
         SvgPainter painter(of, canvas, config.canvas_margin(), style);
-        boost::apply_visitor(painter, scn);
+        if (config.label_size() > 0.)
+            painter.place_labels(scn, config.label_size());
+        scn.paint(painter);
     }
     catch (const ConfigError & e)
     {
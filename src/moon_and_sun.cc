@@ -72,12 +72,14 @@ const std::string MoonOrSun::name() const
 ln_equ_posn MoonOrSun::get_equ_coords(double JD) const
 {
     ln_equ_posn ret;
+    std::lock_guard<std::mutex> lock(libnova_mutex());
     imp_->get_equ_coords(JD, &ret);
     return ret;
 }
 
 double MoonOrSun::get_sdiam(double JD) const
 {
+    std::lock_guard<std::mutex> lock(libnova_mutex());
     return imp_->get_sdiam(JD);
 }
 
@@ -93,6 +93,7 @@ const std::string Planet::name() const
 ln_equ_posn Planet::get_equ_coords(double JD) const
 {
     ln_equ_posn ret;
+    std::lock_guard<std::mutex> lock(libnova_mutex());
     imp_->get_equ_coords(JD, &ret);
     return ret;
 }
@@ -104,5 +105,6 @@ double Planet::get_sdiam(double) const
 
 double Planet::get_magnitude(double JD) const
 {
+    std::lock_guard<std::mutex> lock(libnova_mutex());
     return imp_->get_magnitude(JD);
 }
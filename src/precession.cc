@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "precession.hh"
+
+#include <libnova/utility.h>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+
+RotationMatrix compute_precession(double fromJD, double toJD)
+{
+    // Lieske et al. 1977, as in libnova
+    const double T((fromJD - JD2000) / 36525.);
+    const double t((toJD - fromJD) / 36525.);
+
+    const double zeta((2306.2181 + 1.39656 * T - 0.000139 * T * T) * t
+                      + (0.30188 - 0.000344 * T) * t * t + 0.017998 * t * t * t);
+    const double z((2306.2181 + 1.39656 * T - 0.000139 * T * T) * t
+                   + (1.09468 + 0.000066 * T) * t * t + 0.018203 * t * t * t);
+    const double theta((2004.3109 - 0.85330 * T - 0.000217 * T * T) * t
+                       - (0.42665 + 0.000217 * T) * t * t - 0.041833 * t * t * t);
+
+    // ra += zeta, tilt by theta towards the new pole, ra += z
+    return RotationMatrix::about_z(ln_deg_to_rad(z / 3600.))
+        * RotationMatrix::about_y(-ln_deg_to_rad(theta / 3600.))
+        * RotationMatrix::about_z(ln_deg_to_rad(zeta / 3600.));
+}
+
+}
+
+RotationMatrix precession_matrix(double fromJD, double toJD)
+{
+    if (fromJD == toJD)
+        return RotationMatrix::identity();
+
+    static std::mutex mutex;
+    static std::map<std::pair<double, double>, RotationMatrix> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key(std::make_pair(fromJD, toJD));
+    auto i(cache.find(key));
+    if (cache.end() == i)
+        i = cache.insert(std::make_pair(key, compute_precession(fromJD, toJD))).first;
+    return i->second;
+}
@@ -25,11 +25,12 @@
 #include <boost/algorithm/string.hpp>
 #include <array>
 #include <cmath>
-#include <libnova/precession.h>
 #include <libnova/utility.h>
+#include <limits>
 #include <stdexcept>
 
 #include "exceptions.hh"
+#include "precession.hh"
 
 namespace {
 
@@ -42,42 +43,6 @@ struct vec
 
 };
 
-template <typename T, int D>
-vec<T, D> operator*(T l, const vec<T,D> & r)
-{
-    vec<T, D> ret;
-    for (int i(0); i < D; ++i)
-        ret[i] = l * r[i];
-    return ret;
-}
-
-template <typename T, int D>
-vec<T, D> operator+(vec<T, D> l, const vec<T, D> & r)
-{
-    for (int i(0); i < D; ++i)
-        l[i] += r[i];
-    return l;
-}
-
-template <typename T, int D>
-T operator*(const vec<T, D> & l, const vec<T, D> & r)
-{
-    T ret = {};
-    for (int i(0); i < D; ++i)
-        ret += l[i] * r[i];
-    return ret;
-}
-
-template <typename T>
-vec<T, 3> cross(const vec<T, 3> & l, const vec<T, 3> & r)
-{
-    return vec<T, 3>{{{
-                l[1]*r[2] - r[1]*l[2],
-                r[0]*l[2] - l[0]*r[2],
-                l[0]*r[1] - r[0]*l[1]
-                    }}};
-}
-
 typedef vec<long double, 3> vec3;
 
 }
@@ -95,7 +60,9 @@ SphericalCoord::SphericalCoord(double r, double d)
 
 Projection::Projection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas, const ln_equ_posn & center)
     : canvas_(canvas), apparent_canvas_(apparent_canvas), center_(center),
-      rotationSin_(0.), rotationCos_(1.)
+      rotationSin_(0.), rotationCos_(1.),
+      frame_(RotationMatrix::identity()), post_{{1., 0.}, {0., 1.}}, latOffset_(0.),
+      isa_(simd::detect_isa()), precision_(simd::Precision::Double), kernels_(simd::kernels(isa_))
 {
     if (0. == apparent_canvas_.ra)
     {
@@ -121,109 +88,530 @@ Projection::~Projection()
 
 CanvasPoint Projection::project(const ln_equ_posn & pos) const
 {
-    return project_imp(SphericalCoord{pos});
+    CanvasPoint ret;
+    project_many(&pos.ra, &pos.dec, 1, &ret);
+    return ret;
+}
+
+void Projection::project_many(const double * ra, const double * dec, std::size_t n, CanvasPoint * out) const
+{
+    project_many(ra, dec, n, RotationMatrix::identity(), out);
+}
+
+void Projection::project_many(const double * ra, const double * dec, std::size_t n, const RotationMatrix & frame,
+                              CanvasPoint * out) const
+{
+    const simd::FrameParams params(frame_params(frame));
+    EquatorialProjector projector(params, kernels_, ra, dec, n, out);
+    boost::apply_visitor(projector, kernel_);
+}
+
+void Projection::project_many(const SkyVector * pos, std::size_t n, const RotationMatrix & frame, CanvasPoint * out) const
+{
+    const simd::FrameParams params(frame_params(frame));
+    VectorProjector projector(params, kernels_, pos, n, out);
+    boost::apply_visitor(projector, kernel_);
+}
+
+std::vector<CanvasPoint> Projection::project_many(const std::vector<ln_equ_posn> & pos, const RotationMatrix & frame) const
+{
+    std::vector<double> ra, dec;
+    ra.reserve(pos.size());
+    dec.reserve(pos.size());
+    for (auto const & p : pos)
+    {
+        ra.push_back(p.ra);
+        dec.push_back(p.dec);
+    }
+
+    std::vector<CanvasPoint> ret(pos.size());
+    project_many(ra.data(), dec.data(), pos.size(), frame, ret.data());
+    return ret;
+}
+
+ln_equ_posn Projection::unproject(const CanvasPoint & pos) const
+{
+    SkyVector v;
+    unproject_many(&pos, 1, &v);
+    return v.equ();
+}
+
+void Projection::unproject_many(const CanvasPoint * pos, std::size_t n, SkyVector * out) const
+{
+    const simd::FrameParams params(frame_params(RotationMatrix::identity()));
+    InverseProjector projector(params, pos, n, out);
+    boost::apply_visitor(projector, kernel_);
+}
+
+std::vector<ln_equ_posn> Projection::unproject_many(const std::vector<CanvasPoint> & pos) const
+{
+    std::vector<SkyVector> v(pos.size());
+    unproject_many(pos.data(), pos.size(), v.data());
+
+    std::vector<ln_equ_posn> ret;
+    ret.reserve(v.size());
+    for (auto const & i : v)
+        ret.push_back(i.equ());
+    return ret;
+}
+
+Jacobian Projection::jacobian(const ln_equ_posn & pos) const
+{
+    const SkyVector v(pos);
+    Jacobian ret;
+    jacobian_many(&v, 1, RotationMatrix::identity(), &ret);
+    return ret;
+}
+
+void Projection::jacobian_many(const SkyVector * pos, std::size_t n, const RotationMatrix & frame, Jacobian * out) const
+{
+    const simd::FrameParams params(frame_params(frame));
+    JacobianProjector projector(params, pos, n, out);
+    boost::apply_visitor(projector, kernel_);
 }
 
 double Projection::scale_at_point(const ln_equ_posn & pos) const
 {
-    ln_equ_posn p2(pos);
-    p2.ra += 0.1;
-    CanvasPoint o1(this->project(pos)), o2(this->project(p2));
-    return (o1.x - o2.x) * 10.;
+    return jacobian(pos).scale() * M_PI / 180.;
 }
 
 void Projection::rotate_to_level(const ln_equ_posn & beg, const ln_equ_posn & end)
 {
-    CanvasPoint center(project(beg)),
-        leveling(project(end));
-
-    CanvasPoint diff(center - leveling);
-    double angle(M_PI - std::atan2(diff.y, diff.x));
+    rotationSin_ = 0.;
+    rotationCos_ = 1.;
+    this->update_frame();
+
+    // the direction from beg to end at the centre, and where the
+    // unrotated projection takes it
+    const SkyVector centre(cos(center_.dec) * cos(center_.ra), cos(center_.dec) * sin(center_.ra), sin(center_.dec));
+    const SkyVector b(beg), e(end), d(e.x - b.x, e.y - b.y, e.z - b.z);
+    SkyVector east, north;
+    tangents(centre, east, north);
+    const double direction[2] = {dot(d, east), dot(d, north)};
+    Jacobian j;
+    jacobian_many(&centre, 1, RotationMatrix::identity(), &j);
+
+    const double angle(level_angle(direction, j));
     rotationSin_ = std::sin(angle);
     rotationCos_ = std::cos(angle);
+    this->update_frame();
+}
 
-    this->rotate_to_level_imp();
+double Projection::level_angle(const double (&direction)[2], const Jacobian & j) const
+{
+    return -std::atan2(j.m[1][0] * direction[0] + j.m[1][1] * direction[1],
+                       j.m[0][0] * direction[0] + j.m[0][1] * direction[1]);
 }
 
-void Projection::rotate_to_level_imp()
-{ }
+double Projection::sphere_level_angle(const double (&direction)[2], const Jacobian & j)
+{
+    // from direction to the one projected to the right, j's inverse
+    // applied to the x axis
+    const double det(j.m[0][0] * j.m[1][1] - j.m[0][1] * j.m[1][0]);
+    return std::atan2(-j.m[1][0] / det, j.m[1][1] / det) - std::atan2(direction[1], direction[0]);
+}
+
+double Projection::visible_min_cos() const
+{
+    return -1.;
+}
 
 double Projection::max_distance() const
 {
     return canvas_.x / 4.;
 }
 
-class AzimuthalEquidistantProjection
+SkyCap Projection::visible_region(double margin) const
+{
+    // Without the centre's antipode in it, the canvas is farthest from
+    // the centre somewhere on its edge.  That's sampled, allowing for
+    // the distance between samples.
+    static const int samples_per_side{64};
+    const SkyVector centre(cos(center_.dec) * cos(center_.ra), cos(center_.dec) * sin(center_.ra), sin(center_.dec));
+    const CanvasPoint half(canvas_.x / 2. + margin, canvas_.y / 2. + margin);
+
+    const CanvasPoint antipode(project(SkyVector(-centre.x, -centre.y, -centre.z).equ()));
+    if (!antipode.nan() && std::fabs(antipode.x) <= half.x && std::fabs(antipode.y) <= half.y)
+        return SkyCap::whole_sky();
+
+    const CanvasPoint corners[5] = {{-half.x, -half.y}, {half.x, -half.y}, {half.x, half.y}, {-half.x, half.y},
+                                    {-half.x, -half.y}};
+    std::vector<CanvasPoint> edge;
+    for (int side(0); side < 4; ++side)
+    {
+        for (int i(0); i < samples_per_side; ++i)
+            edge.push_back(corners[side] + (corners[side + 1] - corners[side]) * (double(i) / samples_per_side));
+    }
+    edge.push_back(edge.front());
+
+    std::vector<SkyVector> sky(edge.size());
+    unproject_many(edge.data(), edge.size(), sky.data());
+
+    double max_angle(0.), max_step(0.);
+    for (std::size_t i(0); i < sky.size(); ++i)
+    {
+        // the canvas reaches off the projected sphere, so it may show
+        // all the projection does
+        if (std::isnan(sky[i].x))
+            return SkyCap{centre, visible_min_cos()};
+
+        max_angle = std::max(max_angle, std::acos(std::max(-1., std::min(1., dot(centre, sky[i])))));
+        if (i > 0)
+            max_step = std::max(max_step, std::acos(std::max(-1., std::min(1., dot(sky[i - 1], sky[i])))));
+    }
+
+    const double radius(max_angle + max_step);
+    if (radius >= M_PI)
+        return SkyCap::whole_sky();
+    return SkyCap{centre, std::cos(radius)};
+}
+
+void Projection::isa(simd::Isa isa)
+{
+    isa_ = isa;
+    kernels_ = simd::kernels(isa_, precision_);
+}
+
+simd::Isa Projection::isa() const
+{
+    return isa_;
+}
+
+void Projection::precision(simd::Precision precision)
+{
+    precision_ = precision;
+    kernels_ = simd::kernels(isa_, precision_);
+}
+
+simd::Precision Projection::precision() const
+{
+    return precision_;
+}
+
+double Projection::single_precision_error() const
+{
+    // Close to singularities, i.e. the antipode of azimuthal
+    // projections and the back meridian of cylindrical ones, single
+    // precision loses whole millimetres.  They're all at least 90
+    // degrees away from the centre.
+    if (visible_region(0.).min_cos <= 0.)
+        return std::numeric_limits<double>::infinity();
+
+    // Rounding unit vectors, the frame and intermediate results
+    // displaces positions by less than an epsilon of arc, measured, and
+    // canvas coordinates get rounded too.  Arc errors grow with the
+    // largest local scale on the canvas, sampled over it.
+    static const double arc_ulps{4.}, canvas_ulps{2.};
+    const double epsilon(std::numeric_limits<float>::epsilon());
+
+    std::vector<CanvasPoint> samples;
+    for (int i(-4); i <= 4; ++i)
+    {
+        for (int j(-4); j <= 4; ++j)
+            samples.push_back(CanvasPoint(canvas_.x * i / 8., canvas_.y * j / 8.));
+    }
+    std::vector<SkyVector> sky(samples.size());
+    unproject_many(samples.data(), samples.size(), sky.data());
+    std::vector<Jacobian> jacobians(sky.size());
+    jacobian_many(sky.data(), sky.size(), RotationMatrix::identity(), jacobians.data());
+
+    double scale(0.);
+    for (auto const & j : jacobians)
+    {
+        for (int r(0); r < 2; ++r)
+        {
+            // NaN, where samples are off the sphere, is ignored by max
+            scale = std::max(scale, std::hypot(j.m[r][0], j.m[r][1]));
+        }
+    }
+    return arc_ulps * epsilon * scale + canvas_ulps * epsilon * std::hypot(canvas_.x, canvas_.y) / 2.;
+}
+
+simd::Precision Projection::choose_precision(double tolerance)
+{
+    precision(single_precision_error() <= tolerance ? simd::Precision::Single : simd::Precision::Double);
+    return precision_;
+}
+
+bool Projection::choose_small_field(double)
+{
+    return false;
+}
+
+simd::FrameParams Projection::frame_params(const RotationMatrix & frame) const
+{
+    simd::FrameParams params;
+    const RotationMatrix m(frame_ * frame);
+    for (int i(0); i < 3; ++i)
+    {
+        for (int j(0); j < 3; ++j)
+            params.matrix[i][j] = m.m[i][j];
+    }
+    for (int i(0); i < 2; ++i)
+    {
+        for (int j(0); j < 2; ++j)
+            params.post[i][j] = post_[i][j];
+    }
+    params.lat_offset = latOffset_;
+    return params;
+}
+
+RotationMatrix Projection::level_rotation() const
+{
+    // Rodrigues' formula, with the axis pointing at the centre
+    SphericalCoord axis(center_);
+    axis.dec = M_PI_2 - axis.dec;
+    const vec3 k{{{sin(axis.dec) * cos(axis.ra), sin(axis.dec) * sin(axis.ra), cos(axis.dec)}}};
+    const long double s(rotationSin_), c(rotationCos_), oneMinusCos(1. - rotationCos_);
+    const long double cross[3][3] = {{0., -k[2], k[1]}, {k[2], 0., -k[0]}, {-k[1], k[0], 0.}};
+    RotationMatrix level;
+    for (int i(0); i < 3; ++i)
+    {
+        for (int j(0); j < 3; ++j)
+            level.m[i][j] = double((i == j ? c : 0.) + s * cross[i][j] + oneMinusCos * k[i] * k[j]);
+    }
+    return level;
+}
+
+// Projections distorting only the distance from the centre.
+class AzimuthalProjection
     : public Projection
 {
+protected:
+    double sinCenterDec_, cosCenterDec_;
+
+    AzimuthalProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                        const ln_equ_posn & center, const ProjectionKernel & kernel)
+        : Projection(canvas, apparent_canvas, center),
+          sinCenterDec_(sin(center_.dec)), cosCenterDec_(cos(center_.dec))
+    {
+        kernel_ = kernel;
+        update_frame();
+    }
+
+public:
+    // Rows are directions to the east and north of the centre, and the
+    // centre itself.
+    virtual void update_frame()
+    {
+        const double sinra(sin(center_.ra)), cosra(cos(center_.ra));
+        const double east[3] = {-sinra, cosra, 0.};
+        const double north[3] = {-sinCenterDec_ * cosra, -sinCenterDec_ * sinra, cosCenterDec_};
+        const double centre[3] = {cosCenterDec_ * cosra, cosCenterDec_ * sinra, sinCenterDec_};
+
+        const double s(rotationSin_), c(rotationCos_);
+        if (scaleX_ == scaleY_)
+        {
+            // scaling commutes with the level rotation, so the rotation
+            // turns the east and north directions instead
+            for (int j(0); j < 3; ++j)
+            {
+                frame_.m[0][j] = c * east[j] - s * north[j];
+                frame_.m[1][j] = s * east[j] + c * north[j];
+                frame_.m[2][j] = centre[j];
+            }
+            post_[0][0] = scaleX_; post_[0][1] = 0.;
+            post_[1][0] = 0.; post_[1][1] = scaleY_;
+            return;
+        }
+
+        for (int j(0); j < 3; ++j)
+        {
+            frame_.m[0][j] = east[j];
+            frame_.m[1][j] = north[j];
+            frame_.m[2][j] = centre[j];
+        }
+        post_[0][0] = c * scaleX_; post_[0][1] = -s * scaleY_;
+        post_[1][0] = s * scaleX_; post_[1][1] = c * scaleY_;
+    }
+};
+
+class AzimuthalEquidistantProjection final
+    : public AzimuthalProjection
+{
 public:
     AzimuthalEquidistantProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
                                    const ln_equ_posn & center)
-        : Projection(canvas, apparent_canvas, center)
+        : AzimuthalProjection(canvas, apparent_canvas, center, AzimuthalEquidistantKernel())
     {
     }
 
-    virtual CanvasPoint project_imp(const SphericalCoord & pos) const
+    virtual bool choose_small_field(double tolerance)
     {
-        double cosc(sin(center_.dec) * sin(pos.dec) + cos(center_.dec) * cos(pos.dec) * cos(pos.ra - center_.ra));
-        double c(acos(cosc));
-        if (fabs(c - M_PI) < 0.0001)
-            return CanvasPoint{NAN, NAN};
-
-        double k;
-        if (c == 0)
-            k = 1;
+        // The series is worth it when the whole canvas lies within its
+        // reach; farther positions fall back to the exact kernel
+        // anyway.  Its error is relative to the distance from the
+        // centre, which is at most asin(sqrt(series_max_s2)) there.
+        const SkyCap region(visible_region(0.));
+        const double error(simd::series_error * asin(sqrt(simd::series_max_s2))
+                           * std::max(fabs(scaleX_), fabs(scaleY_)));
+        const bool small(region.min_cos > 0. && 1. - region.min_cos * region.min_cos <= simd::series_max_s2
+                         && error <= tolerance);
+        if (small)
+            kernel_ = AzimuthalEquidistantSeriesKernel();
         else
-            k = c / sin(c);
-        double x(k * cos(pos.dec) * sin(pos.ra - center_.ra));
-        double y(k * (cos(center_.dec) * sin(pos.dec) - sin(center_.dec) * cos(pos.dec) * cos(pos.ra - center_.ra)));
+            kernel_ = AzimuthalEquidistantKernel();
+        return small;
+    }
 
-        return CanvasPoint(scaleX_ * x, scaleY_ * y)
-            .rotate(rotationSin_, rotationCos_);
+protected:
+    virtual double visible_min_cos() const
+    {
+        return -cos(simd::antipode_distance);
     }
 };
 
-class CylindricalEquidistantProjection
+class CylindricalEquidistantProjection final
     : public Projection
 {
-    vec3 rotation_axis_;
 public:
     CylindricalEquidistantProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
                                      const ln_equ_posn & center)
-        : Projection(canvas, apparent_canvas, center),
-          rotation_axis_{{{ 1., 0., 0. }}}
-    { }
+        : Projection(canvas, apparent_canvas, center)
+    {
+        kernel_ = CylindricalEquidistantKernel();
+        update_frame();
+    }
+
+    virtual double level_angle(const double (&direction)[2], const Jacobian & j) const
+    {
+        return sphere_level_angle(direction, j);
+    }
+
+    // Level rotation about the centre, followed by turning the centre's
+    // meridian onto longitude 0.
+    virtual void update_frame()
+    {
+        frame_ = RotationMatrix::about_z(-center_.ra) * level_rotation();
+
+        post_[0][0] = scaleX_; post_[0][1] = 0.;
+        post_[1][0] = 0.; post_[1][1] = scaleY_;
+        latOffset_ = center_.dec;
+    }
+};
+
+// Projections of the whole sphere, with the centre on longitude and
+// latitude 0.
+class PseudoCylindricalProjection
+    : public Projection
+{
+protected:
+    PseudoCylindricalProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                                const ln_equ_posn & center, const ProjectionKernel & kernel)
+        : Projection(canvas, apparent_canvas, center)
+    {
+        kernel_ = kernel;
+        update_frame();
+    }
+
+    // e.g. Mollweide projection stretches the centre vertically, so
+    // the level rotation turns the sphere, by the angle that brings the
+    // direction where it's projected to the right.
+    virtual double level_angle(const double (&direction)[2], const Jacobian & j) const
+    {
+        return sphere_level_angle(direction, j);
+    }
+
+public:
+    virtual void update_frame()
+    {
+        frame_ = RotationMatrix::about_y(center_.dec) * RotationMatrix::about_z(-center_.ra) * level_rotation();
+
+        post_[0][0] = scaleX_; post_[0][1] = 0.;
+        post_[1][0] = 0.; post_[1][1] = scaleY_;
+    }
+};
+
+class StereographicProjection final
+    : public AzimuthalProjection
+{
+public:
+    StereographicProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                            const ln_equ_posn & center)
+        : AzimuthalProjection(canvas, apparent_canvas, center, StereographicKernel())
+    {
+    }
+
+protected:
+    virtual double visible_min_cos() const
+    {
+        return simd::antipode_min_z;
+    }
+};
+
+class GnomonicProjection final
+    : public AzimuthalProjection
+{
+public:
+    GnomonicProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                       const ln_equ_posn & center)
+        : AzimuthalProjection(canvas, apparent_canvas, center, GnomonicKernel())
+    {
+    }
 
-    virtual CanvasPoint project_imp(const SphericalCoord & pos) const
+protected:
+    // less than a hemisphere, as the projection grows without bounds
+    // towards its edge
+    virtual double visible_min_cos() const
     {
-        SphericalCoord rotated = rotate(pos);
-        double x(rotated.ra - center_.ra);
-        if (x > M_PI)
-            x -= 2 * M_PI;
-        else if (x < -M_PI)
-            x += 2 * M_PI;
-        double y(rotated.dec - center_.dec);
+        return simd::gnomonic_min_z;
+    }
+};
 
-        return CanvasPoint(scaleX_ * x, scaleY_ * y);
+class OrthographicProjection final
+    : public AzimuthalProjection
+{
+public:
+    OrthographicProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                           const ln_equ_posn & center)
+        : AzimuthalProjection(canvas, apparent_canvas, center, OrthographicKernel())
+    {
     }
 
-    virtual void rotate_to_level_imp()
+protected:
+    // the near hemisphere only
+    virtual double visible_min_cos() const
     {
-        SphericalCoord axis(center_);
-        axis.dec = M_PI_2 - axis.dec;
-        rotation_axis_ = {{{sin(axis.dec) * cos(axis.ra), sin(axis.dec) * sin(axis.ra), cos(axis.dec)}}};
+        return 0.;
     }
+};
 
-private:
-    SphericalCoord rotate(SphericalCoord pos) const
+class LambertAzimuthalEqualAreaProjection final
+    : public AzimuthalProjection
+{
+public:
+    LambertAzimuthalEqualAreaProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                                        const ln_equ_posn & center)
+        : AzimuthalProjection(canvas, apparent_canvas, center, LambertAzimuthalEqualAreaKernel())
     {
-        pos.dec = M_PI_2 - pos.dec;
+    }
 
-        vec3 a = {{{sin(pos.dec) * cos(pos.ra),   sin(pos.dec) * sin(pos.ra),   cos(pos.dec)}}};
-        vec3 b = rotationCos_ * a + rotationSin_ * cross(rotation_axis_, a) + (rotation_axis_ * a) * (1. - rotationCos_) * rotation_axis_;
+protected:
+    virtual double visible_min_cos() const
+    {
+        return simd::antipode_min_z;
+    }
+};
 
-        return SphericalCoord(double(std::atan2(b[1], b[0])),
-                              double(M_PI_2 - std::atan2(std::hypot(b[0], b[1]), b[2])));
+class MollweideProjection final
+    : public PseudoCylindricalProjection
+{
+public:
+    MollweideProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                        const ln_equ_posn & center)
+        : PseudoCylindricalProjection(canvas, apparent_canvas, center, MollweideKernel())
+    {
+    }
+};
+
+class HammerAitoffProjection final
+    : public PseudoCylindricalProjection
+{
+public:
+    HammerAitoffProjection(const CanvasPoint & canvas, const ln_equ_posn & apparent_canvas,
+                           const ln_equ_posn & center)
+        : PseudoCylindricalProjection(canvas, apparent_canvas, center, HammerAitoffKernel())
+    {
     }
 };
 
@@ -237,6 +625,18 @@ std::shared_ptr<Projection> ProjectionFactory::create(const std::string & type,
         return std::make_shared<AzimuthalEquidistantProjection>(canvas, apparent_canvas, center);
     if ("cylindricalequidistant" == t)
         return std::make_shared<CylindricalEquidistantProjection>(canvas, apparent_canvas, center);
+    if ("stereographic" == t)
+        return std::make_shared<StereographicProjection>(canvas, apparent_canvas, center);
+    if ("gnomonic" == t)
+        return std::make_shared<GnomonicProjection>(canvas, apparent_canvas, center);
+    if ("orthographic" == t)
+        return std::make_shared<OrthographicProjection>(canvas, apparent_canvas, center);
+    if ("lambertazimuthalequalarea" == t)
+        return std::make_shared<LambertAzimuthalEqualAreaProjection>(canvas, apparent_canvas, center);
+    if ("mollweide" == t)
+        return std::make_shared<MollweideProjection>(canvas, apparent_canvas, center);
+    if ("hammeraitoff" == t)
+        return std::make_shared<HammerAitoffProjection>(canvas, apparent_canvas, center);
 
     throw ConfigError("Unknown projection specified: " + type);
 }
@@ -245,7 +645,5 @@ ln_equ_posn convert_epoch(ln_equ_posn in, double fromJD, double toJD)
 {
     if (fromJD == toJD)
         return in;
-    ln_equ_posn out;
-    ln_get_equ_prec2(&in, fromJD, toJD, &out);
-    return out;
+    return (precession_matrix(fromJD, toJD) * SkyVector(in)).equ();
 }
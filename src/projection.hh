@@ -23,10 +23,15 @@
 #ifndef GRAPH_PROJECTION_HH
 #define GRAPH_PROJECTION_HH 1
 
+#include <cstddef>
 #include <libnova/ln_types.h>
 #include <memory>
+#include <vector>
 
 #include "canvas.hh"
+#include "projection_kernels.hh"
+#include "simd.hh"
+#include "sky_vector.hh"
 
 struct SphericalCoord
 {
@@ -46,22 +51,105 @@ protected:
 
 public:
     virtual ~Projection();
+    // A single position, through the same kernel as project_many().
     CanvasPoint project(const ln_equ_posn & pos) const;
-    virtual double scale_at_point(const ln_equ_posn & pos) const;
+    // Projects n positions given in degrees at once.  Constants
+    // depending on the centre only are computed once per batch, and the
+    // projection type is dispatched once per batch as well.
+    void project_many(const double * ra, const double * dec, std::size_t n, CanvasPoint * out) const;
+    // These rotate positions by frame first.  The frame, e.g. precession
+    // into the chart's epoch, gets fused with projection's own centre
+    // and level rotations into a single matrix.
+    void project_many(const double * ra, const double * dec, std::size_t n, const RotationMatrix & frame,
+                      CanvasPoint * out) const;
+    std::vector<CanvasPoint> project_many(const std::vector<ln_equ_posn> & pos,
+                                          const RotationMatrix & frame = RotationMatrix::identity()) const;
+    // Projects unit vectors.
+    void project_many(const SkyVector * pos, std::size_t n, const RotationMatrix & frame, CanvasPoint * out) const;
+    // Projects unit vectors position(*i) of objects in [begin, end).
+    template <typename Iterator, typename Position>
+    void project_range(Iterator begin, Iterator end, const RotationMatrix & frame, Position position,
+                       CanvasPoint * out) const
+    {
+        const simd::FrameParams params(frame_params(frame));
+        RangeProjector<Iterator, Position> projector(params, kernels_, begin, end, position, out);
+        boost::apply_visitor(projector, kernel_);
+    }
+    // Inverse of project(), undoing the level rotation as well.  Points
+    // outside of the projected sphere, or of its visible part, map to
+    // NaN.
+    ln_equ_posn unproject(const CanvasPoint & pos) const;
+    void unproject_many(const CanvasPoint * pos, std::size_t n, SkyVector * out) const;
+    std::vector<ln_equ_posn> unproject_many(const std::vector<CanvasPoint> & pos) const;
+    // Jacobian of project() at pos, analytic for every projection.
+    Jacobian jacobian(const ln_equ_posn & pos) const;
+    void jacobian_many(const SkyVector * pos, std::size_t n, const RotationMatrix & frame, Jacobian * out) const;
+    // Local scale at pos, in mm per degree.
+    double scale_at_point(const ln_equ_posn & pos) const;
+    // Turns the chart so that the direction from beg to end, both close
+    // to the centre on either side of it, runs to the right.
     void rotate_to_level(const ln_equ_posn & beg, const ln_equ_posn & end);
     double max_distance() const;
+    // Conservative region of the sky projected within margin of the
+    // canvas, in the chart's epoch.  Falls back to all the projection
+    // shows when the canvas reaches outside of the projected sphere.
+    SkyCap visible_region(double margin) const;
+    // Instruction set used by project_many().  Defaults to the widest
+    // available; Isa::Scalar selects the reference implementation.
+    void isa(simd::Isa isa);
+    simd::Isa isa() const;
+    // Arithmetic precision of vectorised kernels, double by default.
+    void precision(simd::Precision precision);
+    simd::Precision precision() const;
+    // Estimated worst error, in mm, of single precision kernels over
+    // the canvas.
+    double single_precision_error() const;
+    // Picks single precision if its error stays within tolerance mm,
+    // double otherwise.
+    simd::Precision choose_precision(double tolerance);
+    // Switches to a faster approximation for small fields, if the
+    // projection has one and its error stays within tolerance mm.
+    // Returns whether it did.
+    virtual bool choose_small_field(double tolerance);
 
 protected:
-    virtual CanvasPoint project_imp(const SphericalCoord & pos) const = 0;
-    virtual void rotate_to_level_imp();
+    // Angle of the level rotation turning direction, given along east
+    // and north of the centre, to the right of the canvas, with j the
+    // Jacobian at the centre without any level rotation.  Defaults to
+    // turning the canvas.
+    virtual double level_angle(const double (&direction)[2], const Jacobian & j) const;
+    // Same, for projections turning the sphere about the centre instead.
+    static double sphere_level_angle(const double (&direction)[2], const Jacobian & j);
+    // Cosine of the largest distance from the centre that's projected,
+    // -1 for the whole sphere.
+    virtual double visible_min_cos() const;
+    // Recomputes frame_, post_ and latOffset_ after centre or level change.
+    virtual void update_frame() = 0;
+    simd::FrameParams frame_params(const RotationMatrix & frame) const;
+    // Level rotation about the centre, as a rotation of the sphere.
+    RotationMatrix level_rotation() const;
 
     const CanvasPoint canvas_;
     SphericalCoord apparent_canvas_;
     const SphericalCoord center_;
     double scaleX_, scaleY_;
     long double rotationSin_, rotationCos_;
+
+    // Rotation of equatorial vectors into the projection's own frame,
+    // where only the map specific distortion remains, and the linear
+    // map from the distorted plane onto the canvas.
+    RotationMatrix frame_;
+    double post_[2][2];
+    double latOffset_;
+    ProjectionKernel kernel_;
+
+    simd::Isa isa_;
+    simd::Precision precision_;
+    const simd::Kernels * kernels_;
 };
 
+// Each type is a subclass of Projection fixing its kernel, and what of
+// the sphere it shows.
 class ProjectionFactory
 {
 public:
@@ -0,0 +1,602 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_PROJECTION_KERNELS_HH
+#define ACHARTS_PROJECTION_KERNELS_HH 1
+
+#include <boost/variant/static_visitor.hpp>
+#include <boost/variant/variant.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+
+#include "canvas.hh"
+#include "simd.hh"
+#include "sky_vector.hh"
+
+/*
+ * Per point arithmetic of each projection, as inline functions of
+ * concrete types.  Loops over positions are templates over these,
+ * instantiated once per projection type and dispatched once per batch
+ * through ProjectionKernel, so nothing stops the compiler from
+ * inlining the whole chain from a catalogue entry to a canvas point.
+ */
+
+inline SkyVector rotate(const simd::FrameParams & p, const SkyVector & v)
+{
+    return SkyVector(p.matrix[0][0] * v.x + p.matrix[0][1] * v.y + p.matrix[0][2] * v.z,
+                     p.matrix[1][0] * v.x + p.matrix[1][1] * v.y + p.matrix[1][2] * v.z,
+                     p.matrix[2][0] * v.x + p.matrix[2][1] * v.y + p.matrix[2][2] * v.z);
+}
+
+inline CanvasPoint post(const simd::FrameParams & p, double x, double y)
+{
+    return CanvasPoint(p.post[0][0] * x + p.post[0][1] * y, p.post[1][0] * x + p.post[1][1] * y);
+}
+
+// Derivatives of a canvas position, in mm per radian, along the
+// directions to the east (column 0) and to the north (column 1) of the
+// projected position.
+struct Jacobian
+{
+    double m[2][2];
+
+    // Local scale, as the square root of the areas' scale.
+    double scale() const
+    {
+        return std::sqrt(std::fabs(m[0][0] * m[1][1] - m[0][1] * m[1][0]));
+    }
+};
+
+// Unit vectors to the east and north of v, in the same frame.  At the
+// poles, where there are no such directions, any perpendicular pair.
+inline void tangents(const SkyVector & v, SkyVector & east, SkyVector & north)
+{
+    const double rho(std::hypot(v.x, v.y));
+    if (0. == rho)
+    {
+        east = SkyVector(0., 1., 0.);
+        north = SkyVector(-v.z, 0., 0.);
+        return;
+    }
+    east = SkyVector(-v.y / rho, v.x / rho, 0.);
+    north = SkyVector(-v.z * v.x / rho, -v.z * v.y / rho, rho);
+}
+
+// Inverse of post(), given the inverse of p.post.
+inline void unpost(const double (&inverse)[2][2], const CanvasPoint & c, double & x, double & y)
+{
+    x = inverse[0][0] * c.x + inverse[0][1] * c.y;
+    y = inverse[1][0] * c.x + inverse[1][1] * c.y;
+}
+
+// Inverses of kernels below return false outside of the projected
+// sphere, or where the projection isn't visible.
+
+// Unit vector in the direction of (k x, k y, z).
+inline bool azimuthal_inverse(double x, double y, double k, double z, SkyVector & v)
+{
+    v = SkyVector(k * x, k * y, z);
+    return true;
+}
+
+// Differential of (k x, k y) along dv, with k depending on z only.
+inline void azimuthal_differential(const SkyVector & v, const SkyVector & dv, double k, double dk, bool visible,
+                                   double & dx, double & dy)
+{
+    if (!visible)
+    {
+        dx = dy = NAN;
+        return;
+    }
+    dx = k * dv.x + dk * dv.z * v.x;
+    dy = k * dv.y + dk * dv.z * v.y;
+}
+
+// Scales x and y of v, rotated into the frame with the centre on z, by
+// k.  Positions which aren't visible are NaN.
+inline CanvasPoint azimuthal(const simd::FrameParams & p, const SkyVector & v, double k, bool visible)
+{
+    if (!visible)
+        return CanvasPoint{NAN, NAN};
+    return post(p, k * v.x, k * v.y);
+}
+
+struct AzimuthalEquidistantKernel
+{
+    static const simd::Map map{simd::Map::AzimuthalEquidistant};
+
+    // v is already rotated into the frame, with the centre on z.
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        const double sinc(std::hypot(v.x, v.y));
+        const double c(std::atan2(sinc, v.z));
+        const double k(0. == sinc ? 1. : c / sinc);
+        return azimuthal(p, v, k, std::fabs(c - M_PI) >= simd::antipode_distance);
+    }
+
+    // Differentials of the plane coordinates, before post(), along a
+    // direction dv tangent to the sphere at v.
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double sinc(std::hypot(v.x, v.y));
+        const double c(std::atan2(sinc, v.z));
+        // k = c / sin(c) is 1 + (1 - z) / 3 close to the centre
+        const double k(sinc < 1e-4 ? 1. + (1. - v.z) / 3. : c / sinc);
+        const double dk(sinc < 1e-4 ? -1. / 3. : (c * v.z - sinc) / (sinc * sinc * sinc));
+        azimuthal_differential(v, dv, k, dk, std::fabs(c - M_PI) >= simd::antipode_distance, dx, dy);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double c(std::hypot(x, y));
+        if (c > M_PI - simd::antipode_distance)
+            return false;
+        return azimuthal_inverse(x, y, 0. == c ? 1. : std::sin(c) / c, std::cos(c), v);
+    }
+};
+
+// Same as above, through the series of simd::series_max_s2 close to
+// the centre.
+struct AzimuthalEquidistantSeriesKernel
+    : AzimuthalEquidistantKernel
+{
+    static const simd::Map map{simd::Map::AzimuthalEquidistantSeries};
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        const double s2(v.x * v.x + v.y * v.y);
+        if (s2 > simd::series_max_s2 || v.z < 0.)
+            return AzimuthalEquidistantKernel::project(p, v);
+
+        const double k(1. + s2 * (1. / 6. + s2 * (3. / 40. + s2 * (5. / 112. + s2 * 35. / 1152.))));
+        return post(p, k * v.x, k * v.y);
+    }
+};
+
+struct StereographicKernel
+{
+    static const simd::Map map{simd::Map::Stereographic};
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        return azimuthal(p, v, 2. / (1. + v.z), v.z > simd::antipode_min_z);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double k(2. / (1. + v.z));
+        azimuthal_differential(v, dv, k, -0.5 * k * k, v.z > simd::antipode_min_z, dx, dy);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double rho2(x * x + y * y), k(4. / (4. + rho2));
+        return azimuthal_inverse(x, y, k, (4. - rho2) / (4. + rho2), v);
+    }
+};
+
+struct GnomonicKernel
+{
+    static const simd::Map map{simd::Map::Gnomonic};
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        return azimuthal(p, v, 1. / v.z, v.z > simd::gnomonic_min_z);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double k(1. / v.z);
+        azimuthal_differential(v, dv, k, -k * k, v.z > simd::gnomonic_min_z, dx, dy);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double k(1. / std::sqrt(1. + x * x + y * y));
+        return k > simd::gnomonic_min_z && azimuthal_inverse(x, y, k, k, v);
+    }
+};
+
+struct OrthographicKernel
+{
+    static const simd::Map map{simd::Map::Orthographic};
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        return azimuthal(p, v, 1., v.z >= 0.);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        azimuthal_differential(v, dv, 1., 0., v.z >= 0., dx, dy);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double rho2(x * x + y * y);
+        return rho2 <= 1. && azimuthal_inverse(x, y, 1., std::sqrt(1. - rho2), v);
+    }
+};
+
+struct LambertAzimuthalEqualAreaKernel
+{
+    static const simd::Map map{simd::Map::LambertAzimuthalEqualArea};
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        return azimuthal(p, v, std::sqrt(2. / (1. + v.z)), v.z > simd::antipode_min_z);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double k(std::sqrt(2. / (1. + v.z)));
+        azimuthal_differential(v, dv, k, -0.5 * k / (1. + v.z), v.z > simd::antipode_min_z, dx, dy);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double rho2(x * x + y * y);
+        if (rho2 > 4.)
+            return false;
+        return azimuthal_inverse(x, y, std::sqrt(1. - rho2 / 4.), 1. - rho2 / 2., v);
+    }
+};
+
+struct CylindricalEquidistantKernel
+{
+    static const simd::Map map{simd::Map::CylindricalEquidistant};
+
+    // v is already rotated into the frame, with the centre's meridian
+    // on longitude 0.
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        return post(p, std::atan2(v.y, v.x), std::atan2(v.z, std::hypot(v.x, v.y)) - p.lat_offset);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double rho2(v.x * v.x + v.y * v.y);
+        dx = (v.x * dv.y - v.y * dv.x) / rho2;
+        dy = dv.z / std::sqrt(rho2);
+    }
+
+    static bool unproject(const simd::FrameParams & p, double x, double y, SkyVector & v)
+    {
+        const double lat(y + p.lat_offset);
+        if (std::fabs(x) > M_PI || std::fabs(lat) > M_PI_2)
+            return false;
+        v = SkyVector(std::cos(lat) * std::cos(x), std::cos(lat) * std::sin(x), std::sin(lat));
+        return true;
+    }
+};
+
+// Pseudo-cylindrical projections have the centre itself on longitude
+// and latitude 0, and are scaled so that the equator spans 2 pi.
+struct MollweideKernel
+{
+    static const simd::Map map{simd::Map::Mollweide};
+
+    // t, twice the auxiliary angle, solves t + sin t = pi sin(lat)
+    static double auxiliary(const SkyVector & v)
+    {
+        const double k(M_PI * v.z);
+        double t(0.5 * k);
+        if (std::fabs(v.z) > simd::mollweide_polar_z)
+        {
+            const double polar(M_PI - std::cbrt(6. * M_PI * (v.x * v.x + v.y * v.y) / (1. + std::fabs(v.z))));
+            t = v.z < 0. ? -polar : polar;
+        }
+        for (int i(0); i < simd::mollweide_iterations; ++i)
+        {
+            const double d(1. + std::cos(t));
+            if (d > 0.)
+                t -= (t + std::sin(t) - k) / d;
+        }
+        return t;
+    }
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        const double t(auxiliary(v));
+        return post(p, std::atan2(v.y, v.x) * std::cos(0.5 * t), M_PI_2 * std::sin(0.5 * t));
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        const double theta(0.5 * auxiliary(v));
+        const double sintheta(std::sin(theta)), costheta(std::cos(theta));
+        const double dlon((v.x * dv.y - v.y * dv.x) / (v.x * v.x + v.y * v.y));
+        // from 2 theta + sin(2 theta) = pi z
+        const double dtheta(M_PI * dv.z / (4. * costheta * costheta));
+        dx = costheta * dlon - std::atan2(v.y, v.x) * sintheta * dtheta;
+        dy = M_PI_2 * costheta * dtheta;
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        const double sintheta(y / M_PI_2);
+        if (std::fabs(sintheta) > 1.)
+            return false;
+        const double costheta(std::sqrt(1. - sintheta * sintheta));
+        const double lon(0. == costheta ? 0. : x / costheta);
+        if (std::fabs(lon) > M_PI)
+            return false;
+
+        const double sinlat((2. * std::asin(sintheta) + 2. * sintheta * costheta) / M_PI);
+        const double coslat(std::sqrt(std::max(0., 1. - sinlat * sinlat)));
+        v = SkyVector(coslat * std::cos(lon), coslat * std::sin(lon), sinlat);
+        return true;
+    }
+};
+
+struct HammerAitoffKernel
+{
+    static const simd::Map map{simd::Map::HammerAitoff};
+
+    // cos(lat) cos(lon / 2) and cos(lat) sin(lon / 2), the smaller one
+    // from their product rho y / 2, as rho - |x| cancels close to the
+    // centre and its antipode
+    static void half_angles(const SkyVector & v, double rho, double & ch, double & sh)
+    {
+        const double big(std::sqrt(0.5 * rho * (rho + std::fabs(v.x))));
+        const double small(big > 0. ? 0.5 * rho * std::fabs(v.y) / big : 0.);
+        ch = v.x >= 0. ? big : small;
+        sh = std::copysign(v.x >= 0. ? small : big, v.y);
+    }
+
+    static CanvasPoint project(const simd::FrameParams & p, const SkyVector & v)
+    {
+        double ch, sh;
+        half_angles(v, std::hypot(v.x, v.y), ch, sh);
+        const double w(M_PI / std::sqrt(1. + ch));
+        return post(p, w * sh, 0.5 * w * v.z);
+    }
+
+    static void differential(const SkyVector & v, const SkyVector & dv, double & dx, double & dy)
+    {
+        // (ch + i sh)^2 = rho (x + i y)
+        const double rho(std::hypot(v.x, v.y));
+        double ch, sh;
+        half_angles(v, rho, ch, sh);
+        const std::complex<double> h(ch, sh);
+        const double drho((v.x * dv.x + v.y * dv.y) / rho);
+        const std::complex<double> dh((drho * std::complex<double>(v.x, v.y) + rho * std::complex<double>(dv.x, dv.y)) /
+                                      (2. * h));
+
+        const double w(std::sqrt(1. + h.real())), dw(0.5 * dh.real() / w);
+        dx = M_PI * (dh.imag() * w - h.imag() * dw) / (w * w);
+        dy = M_PI_2 * (dv.z * w - v.z * dw) / (w * w);
+    }
+
+    static bool unproject(const simd::FrameParams &, double x, double y, SkyVector & v)
+    {
+        // back to the usual scale, with the equator spanning 4 sqrt(2)
+        const double xs(x * 2. * M_SQRT2 / M_PI), ys(y * 2. * M_SQRT2 / M_PI);
+        const double z2(1. - xs * xs / 16. - ys * ys / 4.);
+        if (z2 < 0.5)
+            return false;
+        const double z(std::sqrt(z2));
+        const double lon(2. * std::atan2(z * xs, 2. * (2. * z2 - 1.)));
+        const double sinlat(std::max(-1., std::min(1., z * ys)));
+        const double coslat(std::sqrt(1. - sinlat * sinlat));
+        v = SkyVector(coslat * std::cos(lon), coslat * std::sin(lon), sinlat);
+        return true;
+    }
+};
+
+typedef boost::variant<AzimuthalEquidistantKernel,
+                       AzimuthalEquidistantSeriesKernel,
+                       StereographicKernel,
+                       GnomonicKernel,
+                       OrthographicKernel,
+                       LambertAzimuthalEqualAreaKernel,
+                       CylindricalEquidistantKernel,
+                       MollweideKernel,
+                       HammerAitoffKernel> ProjectionKernel;
+
+// Projects unit vectors, through SIMD kernels if there are any.
+class VectorProjector
+    : public boost::static_visitor<>
+{
+    const simd::FrameParams & params_;
+    const simd::Kernels * kernels_;
+    const SkyVector * pos_;
+    std::size_t n_;
+    CanvasPoint * out_;
+
+public:
+    VectorProjector(const simd::FrameParams & params, const simd::Kernels * kernels,
+                    const SkyVector * pos, std::size_t n, CanvasPoint * out)
+        : params_(params), kernels_(kernels), pos_(pos), n_(n), out_(out)
+    {
+    }
+
+    template <typename Kernel>
+    void operator()(const Kernel &) const
+    {
+        if (kernels_)
+        {
+            kernels_->vectors[std::size_t(Kernel::map)](params_, pos_, n_, out_);
+            return;
+        }
+
+        for (std::size_t i(0); i < n_; ++i)
+            out_[i] = Kernel::project(params_, rotate(params_, pos_[i]));
+    }
+};
+
+// Projects right ascensions and declinations given in degrees.
+class EquatorialProjector
+    : public boost::static_visitor<>
+{
+    const simd::FrameParams & params_;
+    const simd::Kernels * kernels_;
+    const double * ra_;
+    const double * dec_;
+    std::size_t n_;
+    CanvasPoint * out_;
+
+public:
+    EquatorialProjector(const simd::FrameParams & params, const simd::Kernels * kernels,
+                        const double * ra, const double * dec, std::size_t n, CanvasPoint * out)
+        : params_(params), kernels_(kernels), ra_(ra), dec_(dec), n_(n), out_(out)
+    {
+    }
+
+    template <typename Kernel>
+    void operator()(const Kernel &) const
+    {
+        if (kernels_)
+        {
+            kernels_->equatorial[std::size_t(Kernel::map)](params_, ra_, dec_, n_, out_);
+            return;
+        }
+
+        for (std::size_t i(0); i < n_; ++i)
+            out_[i] = Kernel::project(params_, rotate(params_, SkyVector(ln_equ_posn{ra_[i], dec_[i]})));
+    }
+};
+
+// Maps canvas points back to unit vectors in the equatorial frame,
+// NaN where nothing is projected.
+class InverseProjector
+    : public boost::static_visitor<>
+{
+    const simd::FrameParams & params_;
+    double inverse_[2][2];
+    const CanvasPoint * pos_;
+    std::size_t n_;
+    SkyVector * out_;
+
+public:
+    InverseProjector(const simd::FrameParams & params, const CanvasPoint * pos, std::size_t n, SkyVector * out)
+        : params_(params), pos_(pos), n_(n), out_(out)
+    {
+        const double det(params.post[0][0] * params.post[1][1] - params.post[0][1] * params.post[1][0]);
+        inverse_[0][0] = params.post[1][1] / det;
+        inverse_[0][1] = -params.post[0][1] / det;
+        inverse_[1][0] = -params.post[1][0] / det;
+        inverse_[1][1] = params.post[0][0] / det;
+    }
+
+    template <typename Kernel>
+    void operator()(const Kernel &) const
+    {
+        const simd::FrameParams & p(params_);
+        for (std::size_t i(0); i < n_; ++i)
+        {
+            double x, y;
+            SkyVector v;
+            unpost(inverse_, pos_[i], x, y);
+            if (!Kernel::unproject(p, x, y, v))
+            {
+                out_[i] = SkyVector(NAN, NAN, NAN);
+                continue;
+            }
+            // rows of the frame matrix are its inverse's columns
+            out_[i] = SkyVector(p.matrix[0][0] * v.x + p.matrix[1][0] * v.y + p.matrix[2][0] * v.z,
+                                p.matrix[0][1] * v.x + p.matrix[1][1] * v.y + p.matrix[2][1] * v.z,
+                                p.matrix[0][2] * v.x + p.matrix[1][2] * v.y + p.matrix[2][2] * v.z);
+        }
+    }
+};
+
+// Jacobians of the projection at unit vectors.
+class JacobianProjector
+    : public boost::static_visitor<>
+{
+    const simd::FrameParams & params_;
+    const SkyVector * pos_;
+    std::size_t n_;
+    Jacobian * out_;
+
+public:
+    JacobianProjector(const simd::FrameParams & params, const SkyVector * pos, std::size_t n, Jacobian * out)
+        : params_(params), pos_(pos), n_(n), out_(out)
+    {
+    }
+
+    template <typename Kernel>
+    void operator()(const Kernel &) const
+    {
+        const simd::FrameParams & p(params_);
+        for (std::size_t i(0); i < n_; ++i)
+        {
+            SkyVector east, north;
+            tangents(pos_[i], east, north);
+            const SkyVector v(rotate(p, pos_[i]));
+
+            double d[2][2];
+            Kernel::differential(v, rotate(p, east), d[0][0], d[1][0]);
+            Kernel::differential(v, rotate(p, north), d[0][1], d[1][1]);
+            for (int r(0); r < 2; ++r)
+            {
+                for (int c(0); c < 2; ++c)
+                    out_[i].m[r][c] = p.post[r][0] * d[0][c] + p.post[r][1] * d[1][c];
+            }
+        }
+    }
+};
+
+/*
+ * Projects the unit vectors position(*i) of a range of any objects, in
+ * chunks gathered on the stack, without copying the whole range aside.
+ */
+template <typename Iterator, typename Position>
+class RangeProjector
+    : public boost::static_visitor<>
+{
+    const simd::FrameParams & params_;
+    const simd::Kernels * kernels_;
+    Iterator begin_, end_;
+    Position position_;
+    CanvasPoint * out_;
+
+public:
+    RangeProjector(const simd::FrameParams & params, const simd::Kernels * kernels,
+                   Iterator begin, Iterator end, Position position, CanvasPoint * out)
+        : params_(params), kernels_(kernels), begin_(begin), end_(end), position_(position), out_(out)
+    {
+    }
+
+    template <typename Kernel>
+    void operator()(const Kernel & kernel) const
+    {
+        static const std::size_t chunk_size{256};
+        SkyVector chunk[chunk_size];
+
+        CanvasPoint * out(out_);
+        for (Iterator i(begin_); i != end_; )
+        {
+            std::size_t n(0);
+            for ( ; n < chunk_size && i != end_; ++n, ++i)
+                chunk[n] = position_(*i);
+
+            VectorProjector(params_, kernels_, chunk, n, out)(kernel);
+            out += n;
+        }
+    }
+};
+
+#endif
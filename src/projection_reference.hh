@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_PROJECTION_REFERENCE_HH
+#define ACHARTS_PROJECTION_REFERENCE_HH 1
+
+#include <cmath>
+#include <libnova/ln_types.h>
+
+#include "canvas.hh"
+
+/*
+ * Azimuthal and cylindrical equidistant projections, position by
+ * position through spherical trigonometry, as charts were projected
+ * before kernels of projection_kernels.hh, without level rotation.
+ * Kept only as a reference for accuracy of Projection, by
+ * projection_test and bench.
+ */
+class ReferenceProjection
+{
+public:
+    enum class Type
+    {
+        AzimuthalEquidistant,
+        CylindricalEquidistant
+    };
+
+    // Arguments as of ProjectionFactory::create().
+    ReferenceProjection(Type type, const CanvasPoint & canvas, ln_equ_posn apparent_canvas,
+                        const ln_equ_posn & center)
+        : type_(type),
+          ra_(center.ra * M_PI / 180.), dec_(center.dec * M_PI / 180.)
+    {
+        if (0. == apparent_canvas.ra)
+            apparent_canvas.ra = apparent_canvas.dec * canvas.x / canvas.y;
+        else if (0. == apparent_canvas.dec)
+            apparent_canvas.dec = apparent_canvas.ra * canvas.y / canvas.x;
+        scaleX_ = -canvas.x / (apparent_canvas.ra * M_PI / 180.);
+        scaleY_ = -canvas.y / (apparent_canvas.dec * M_PI / 180.);
+    }
+
+    CanvasPoint project(const ln_equ_posn & pos) const
+    {
+        const double ra(pos.ra * M_PI / 180.), dec(pos.dec * M_PI / 180.);
+        if (Type::CylindricalEquidistant == type_)
+        {
+            double x(ra - ra_);
+            if (x > M_PI)
+                x -= 2 * M_PI;
+            else if (x < -M_PI)
+                x += 2 * M_PI;
+            return CanvasPoint(scaleX_ * x, scaleY_ * (dec - dec_));
+        }
+
+        double cosc(sin(dec_) * sin(dec) + cos(dec_) * cos(dec) * cos(ra - ra_));
+        double c(acos(cosc));
+        if (fabs(c - M_PI) < 0.0001)
+            return CanvasPoint{NAN, NAN};
+
+        double k;
+        if (c == 0)
+            k = 1;
+        else
+            k = c / sin(c);
+        double x(k * cos(dec) * sin(ra - ra_));
+        double y(k * (cos(dec_) * sin(dec) - sin(dec_) * cos(dec) * cos(ra - ra_)));
+
+        return CanvasPoint(scaleX_ * x, scaleY_ * y);
+    }
+
+private:
+    Type type_;
+    double ra_, dec_;
+    double scaleX_, scaleY_;
+};
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <libnova/transform.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "projection.hh"
+#include "projection_reference.hh"
+
+/*
+ * Round trips through every projection, levelled to the celestial
+ * equator and to the horizon, at the canvas' aspect and stretched:
+ * positions within 80 degrees of the centre have to come back from the
+ * canvas within sky_tolerance, and points of the canvas that unproject
+ * at all have to come back from the sky within canvas_tolerance.
+ * unproject_many() has to agree with unproject(), and the horizon
+ * through the centre has to run to the right within level_tolerance.
+ *
+ * project() has to give exactly what project_many() does, with the
+ * small field approximation too, and equidistant projections have to
+ * stay within reference_tolerance of ReferenceProjection.
+ */
+
+namespace
+{
+
+const double sky_tolerance{1e-7};     // degrees
+const double canvas_tolerance{1e-7};  // mm
+const double level_tolerance{1e-4};   // radians
+const double reference_tolerance{1e-9};  // mm
+
+const char * const types[]{
+    "AzimuthalEquidistant", "CylindricalEquidistant", "Stereographic", "Gnomonic", "Orthographic",
+    "LambertAzimuthalEqualArea", "Mollweide", "HammerAitoff"};
+
+const CanvasPoint canvas(297., 210.);
+const ln_equ_posn centre{75., 35.};
+const ln_lnlat_posn observer{16.67, 50.57};
+const double t{2456019.3};
+
+// As main levels charts to the horizon.  Returns the angle of the
+// horizon through the centre afterwards, off the canvas' x axis.
+double level_to_horizon(Projection & projection)
+{
+    ln_equ_posn c(centre);
+    ln_hrz_posn hor;
+    ln_get_hrz_from_equ(&c, const_cast<ln_lnlat_posn *>(&observer), t, &hor);
+    ln_hrz_posn hor2(hor);
+    hor.az -= 1.0;
+    hor2.az += 1.0;
+    ln_equ_posn equ, equ2;
+    ln_get_equ_from_hrz(&hor, const_cast<ln_lnlat_posn *>(&observer), t, &equ);
+    ln_get_equ_from_hrz(&hor2, const_cast<ln_lnlat_posn *>(&observer), t, &equ2);
+    projection.rotate_to_level(equ, equ2);
+
+    const CanvasPoint d(projection.project(equ2) - projection.project(equ));
+    return std::atan2(d.y, d.x);
+}
+
+double angle(const ln_equ_posn & l, const ln_equ_posn & r)
+{
+    const SkyVector a(l), b(r);
+    const double chord(std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z)));
+    return 2. * std::asin(chord / 2.) * 180. / M_PI;
+}
+
+int check(const std::string & type, const std::string & level, const ln_equ_posn & apparent)
+{
+    std::shared_ptr<Projection> projection(ProjectionFactory::create(type, canvas, apparent, centre));
+    const double tilt("horizon" == level ? level_to_horizon(*projection) : 0.);
+
+    int failures(0);
+    const std::string name(type + ", level " + level + (0. == apparent.dec ? "" : ", stretched"));
+    if (! (std::fabs(tilt) <= level_tolerance))
+    {
+        std::cerr << name << ": horizon off level by " << tilt << " radians" << std::endl;
+        ++failures;
+    }
+
+    // sky to canvas to sky
+    const SkyVector c(centre);
+    double worst(0.);
+    for (double ra(0.); ra < 360.; ra += 7.)
+    {
+        for (double dec(-87.); dec < 90.; dec += 6.)
+        {
+            const ln_equ_posn pos{ra, dec};
+            const SkyVector v(pos);
+            if (v.x * c.x + v.y * c.y + v.z * c.z < std::cos(80. * M_PI / 180.))
+                continue;
+            const CanvasPoint p(projection->project(pos));
+            if (! std::isfinite(p.x) || ! std::isfinite(p.y))
+            {
+                std::cerr << name << ": " << ra << ' ' << dec << " doesn't project" << std::endl;
+                ++failures;
+                continue;
+            }
+            worst = std::max(worst, angle(pos, projection->unproject(p)));
+        }
+    }
+    if (! (worst <= sky_tolerance))
+    {
+        std::cerr << name << ": sky to canvas to sky off by " << worst << " degrees" << std::endl;
+        ++failures;
+    }
+
+    // canvas to sky to canvas, one by one and at once
+    std::vector<CanvasPoint> points;
+    for (double x(-canvas.x); x <= canvas.x; x += canvas.x / 16.)
+    {
+        for (double y(-canvas.y); y <= canvas.y; y += canvas.y / 16.)
+            points.push_back(CanvasPoint(x + 0.1, y + 0.1));
+    }
+    const std::vector<ln_equ_posn> many(projection->unproject_many(points));
+    std::size_t unprojected(0);
+    worst = 0.;
+    double disagreement(0.);
+    for (std::size_t i(0); i < points.size(); ++i)
+    {
+        const ln_equ_posn pos(projection->unproject(points[i]));
+        if (std::isnan(pos.ra) != std::isnan(many[i].ra))
+        {
+            disagreement = INFINITY;
+            continue;
+        }
+        if (std::isnan(pos.ra))
+            continue;
+        ++unprojected;
+        disagreement = std::max(disagreement, angle(pos, many[i]));
+        const CanvasPoint back(projection->project(pos));
+        worst = std::max(worst, std::hypot(back.x - points[i].x, back.y - points[i].y));
+    }
+    if (0 == unprojected || ! (worst <= canvas_tolerance))
+    {
+        std::cerr << name << ": canvas to sky to canvas off by " << worst << " mm, "
+                  << unprojected << " points unprojected" << std::endl;
+        ++failures;
+    }
+    if (! (disagreement <= sky_tolerance))
+    {
+        std::cerr << name << ": unproject_many() differs from unproject() by " << disagreement << " degrees"
+                  << std::endl;
+        ++failures;
+    }
+    return failures;
+}
+
+// Of wide and narrow charts, where the small field approximation
+// applies.
+int check_project(const std::string & type)
+{
+    int failures(0);
+    for (double field : {120., 2.})
+    {
+        std::shared_ptr<Projection> projection(ProjectionFactory::create(type, canvas, ln_equ_posn{field, 0.}, centre));
+        const bool series(projection->choose_small_field(0.01));
+        const std::string name(type + ", " + std::to_string(int(field)) + " degrees" + (series ? ", series" : ""));
+
+        std::vector<ln_equ_posn> pos;
+        for (double ra(-field); ra <= field; ra += field / 16.)
+        {
+            for (double dec(-field); dec <= field; dec += field / 16.)
+                pos.push_back(ln_equ_posn{centre.ra + ra + 0.01, std::max(-90., std::min(90., centre.dec + dec))});
+        }
+        const std::vector<CanvasPoint> many(projection->project_many(pos));
+
+        int differ(0);
+        double off_reference(0.);
+        const bool equidistant("AzimuthalEquidistant" == type || "CylindricalEquidistant" == type);
+        const ReferenceProjection reference("AzimuthalEquidistant" == type
+                                            ? ReferenceProjection::Type::AzimuthalEquidistant
+                                            : ReferenceProjection::Type::CylindricalEquidistant,
+                                            canvas, ln_equ_posn{field, 0.}, centre);
+        for (std::size_t i(0); i < pos.size(); ++i)
+        {
+            const CanvasPoint p(projection->project(pos[i]));
+            if (! (p.x == many[i].x && p.y == many[i].y) && ! (p.nan() && many[i].nan()))
+                ++differ;
+
+            if (! equidistant || p.nan() || dot(SkyVector(pos[i]), SkyVector(centre)) < std::cos(80. * M_PI / 180.))
+                continue;
+            const CanvasPoint r(reference.project(pos[i]));
+            off_reference = std::max(off_reference, std::hypot(p.x - r.x, p.y - r.y));
+        }
+        if (differ)
+        {
+            std::cerr << name << ": project() differs from project_many() at " << differ << " positions" << std::endl;
+            ++failures;
+        }
+        if (! (off_reference <= (series ? 0.01 : reference_tolerance)))
+        {
+            std::cerr << name << ": project() off the reference by " << off_reference << " mm" << std::endl;
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+}
+
+int main()
+{
+    int failures(0);
+    for (const char * type : types)
+    {
+        failures += check_project(type);
+        for (const ln_equ_posn & apparent : {ln_equ_posn{120., 0.}, ln_equ_posn{120., 40.}})
+        {
+            failures += check(type, "none", apparent);
+            failures += check(type, "horizon", apparent);
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -22,23 +22,555 @@
  */
 #include "scene.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
 #include <libnova/transform.h>
 
 #include "constellations.hh"
 #include "drawer.hh"
+#include "exceptions.hh"
+#include "precession.hh"
 
 namespace scene
 {
 
-Scene::Scene(const std::shared_ptr<Projection> & projection)
-    : projection_(projection),
-      scene_{"", "root", {}}
+DisplayList::DisplayList(Arena * arena, const CanvasBox & clip)
+    : clip_(clip), bounds_(CanvasBox::empty()), open_(arena), skips_(arena), runs_(arena), groups_(arena), insets_(arena), objects_(arena), proportional_objects_(arena),
+      labelled_objects_(arena), directed_objects_(arena), rectangles_(arena), lines_(arena),
+      points_(arena), path_ends_(arena), texts_(arena)
 {
 }
 
-void Scene::add_group(Group && group)
+void DisplayList::push(Kind kind)
 {
-    scene_.elements.push_back(std::move(group));
+    // markers aren't merged, as each of them gets painted on its own
+    if (! runs_.empty() && runs_.back().kind == kind && kind > Kind::End)
+        ++runs_.back().count;
+    else
+        runs_.push_back(Run{kind, 1});
+}
+
+CanvasBox & DisplayList::innermost()
+{
+    return open_.empty() ? bounds_ : open_.back().bounds;
+}
+
+void DisplayList::extend(const CanvasPoint & p)
+{
+    innermost().extend(p);
+}
+
+DisplayList::Position DisplayList::position() const
+{
+    return Position{{groups_.size(), insets_.size(), 0, objects_.size(), proportional_objects_.size(),
+                labelled_objects_.size(), directed_objects_.size(), rectangles_.size(), lines_.size(),
+                path_ends_.size(), texts_.size()}};
+}
+
+void DisplayList::begin(const Group & group)
+{
+    push(Kind::BeginGroup);
+    groups_.push_back(group);
+    groups_.back().bounds = CanvasBox::empty();
+    skips_.push_back(Skip{});
+    open_.push_back(Open{Kind::BeginGroup, groups_.size() - 1, CanvasBox::empty()});
+}
+
+void DisplayList::begin(const Inset & inset)
+{
+    push(Kind::BeginInset);
+    insets_.push_back(inset);
+    open_.push_back(Open{Kind::BeginInset, insets_.size() - 1, CanvasBox::empty()});
+}
+
+void DisplayList::end()
+{
+    if (open_.empty())
+        throw InternalError("Display list closing a group it hasn't opened");
+
+    push(Kind::End);
+    const Open closed(open_.back());
+    open_.pop_back();
+
+    CanvasBox & parent(innermost());
+    if (Kind::BeginGroup == closed.kind)
+    {
+        groups_[closed.index].bounds = closed.bounds;
+        skips_[closed.index] = Skip{runs_.size() - 1, position()};
+        parent.extend(closed.bounds);
+    }
+    else
+    {
+        // contents are in the inset's own coordinates
+        const Inset & inset(insets_[closed.index]);
+        parent.extend(CanvasBox{inset.position - inset.size / 2., inset.position + inset.size / 2.});
+    }
+}
+
+void DisplayList::add(const Object & o)
+{
+    if (! clip_.contains(o.pos))
+        return;
+    extend(o.pos);
+    push(Kind::Object);
+    objects_.push_back(o);
+}
+
+void DisplayList::add(const ProportionalObject & o)
+{
+    if (! clip_.contains(o.pos))
+        return;
+    extend(o.pos);
+    push(Kind::ProportionalObject);
+    proportional_objects_.push_back(o);
+}
+
+void DisplayList::add(const LabelledObject & o)
+{
+    if (! clip_.contains(o.pos))
+        return;
+    extend(o.pos);
+    push(Kind::LabelledObject);
+    labelled_objects_.push_back(o);
+}
+
+void DisplayList::add(const DirectedObject & o)
+{
+    if (! clip_.contains(o.pos))
+        return;
+    extend(o.pos);
+    push(Kind::DirectedObject);
+    directed_objects_.push_back(o);
+}
+
+void DisplayList::add(const Rectangle & r)
+{
+    extend(r.start);
+    extend(r.start + r.size);
+    push(Kind::Rectangle);
+    rectangles_.push_back(r);
+}
+
+void DisplayList::add(const Line & l)
+{
+    extend(l.start);
+    extend(l.end);
+    push(Kind::Line);
+    lines_.push_back(l);
+}
+
+void DisplayList::add(const BezierCurve & path)
+{
+    // each run of segments crossing clip becomes a path of its own
+    const BezierPoint * run(nullptr);
+    for (const BezierPoint * p(path.data()), * end(path.data() + path.size()); p != end; ++p)
+    {
+        const bool visible(p + 1 != end && clip_.crosses(p->p, (p + 1)->p));
+        if (visible && ! run)
+            run = p;
+        else if (! visible && run)
+        {
+            add_path(run, p + 1);
+            run = nullptr;
+        }
+    }
+}
+
+void DisplayList::add_path(const BezierPoint * begin, const BezierPoint * end)
+{
+    push(Kind::Path);
+    for (auto p(begin); p != end; ++p)
+    {
+        extend(p->p);
+        extend(p->cm);
+        extend(p->cp);
+    }
+    points_.insert(points_.end(), begin, end);
+    path_ends_.push_back(points_.size());
+}
+
+void DisplayList::add(const Text & t)
+{
+    if (! clip_.contains(t.pos))
+        return;
+    extend(t.pos);
+    push(Kind::Text);
+    texts_.push_back(t);
+}
+
+namespace
+{
+
+template <typename Vector>
+void move_back(Vector & to, Vector & from)
+{
+    to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+    from.clear();
+}
+
+}
+
+void DisplayList::append(DisplayList && rh)
+{
+    if (! rh.open_.empty())
+        throw InternalError("Appending a display list with groups left open");
+
+    // skips of rh move by what is here already, less its first run if
+    // that gets merged with the last one here
+    const Position offset(position());
+    const bool merged(! runs_.empty() && ! rh.runs_.empty() && runs_.back().kind == rh.runs_.front().kind
+                      && rh.runs_.front().kind > Kind::End);
+    const std::size_t runs(runs_.size() - (merged ? 1 : 0));
+    for (auto skip : rh.skips_)
+    {
+        skip.run += runs;
+        for (std::size_t k(0); k < kinds; ++k)
+            skip.position[k] += offset[k];
+        skips_.push_back(skip);
+    }
+    rh.skips_.clear();
+
+    innermost().extend(rh.bounds_);
+    rh.bounds_ = CanvasBox::empty();
+
+    for (auto const & run : rh.runs_)
+    {
+        if (! runs_.empty() && runs_.back().kind == run.kind && run.kind > Kind::End)
+            runs_.back().count += run.count;
+        else
+            runs_.push_back(run);
+    }
+    rh.runs_.clear();
+
+    const std::size_t points(points_.size());
+    for (auto end : rh.path_ends_)
+        path_ends_.push_back(points + end);
+    rh.path_ends_.clear();
+
+    move_back(groups_, rh.groups_);
+    move_back(insets_, rh.insets_);
+    move_back(objects_, rh.objects_);
+    move_back(proportional_objects_, rh.proportional_objects_);
+    move_back(labelled_objects_, rh.labelled_objects_);
+    move_back(directed_objects_, rh.directed_objects_);
+    move_back(rectangles_, rh.rectangles_);
+    move_back(lines_, rh.lines_);
+    move_back(points_, rh.points_);
+    move_back(texts_, rh.texts_);
+}
+
+namespace
+{
+
+// Version of the format, to be bumped with every change to it.
+const char scene_magic[8] = { 'A', 'C', 'S', 'C', 'N', '0', '2', '\n' };
+
+// Bytes left in is, all of which it has to have buffered.
+std::uint64_t remaining(std::istream & is)
+{
+    const std::streamsize left(is.rdbuf()->in_avail());
+    return left > 0 ? left : 0;
+}
+
+template <typename T>
+void put(std::ostream & os, const T & t)
+{
+    os.write(reinterpret_cast<const char *>(&t), sizeof(t));
+}
+
+template <typename T>
+bool get(std::istream & is, T & t)
+{
+    return bool(is.read(reinterpret_cast<char *>(&t), sizeof(t)));
+}
+
+void put(std::ostream & os, const std::string & s)
+{
+    put(os, std::uint32_t(s.size()));
+    os.write(s.data(), s.size());
+}
+
+bool get(std::istream & is, std::string & s)
+{
+    std::uint32_t size;
+    if (! get(is, size) || size > remaining(is))
+        return false;
+    s.resize(size);
+    return bool(is.read(&s[0], size));
+}
+
+void put(std::ostream & os, const Group & g)
+{
+    put(os, g.class_);
+    put(os, g.id);
+    put(os, g.bounds);
+}
+
+bool get(std::istream & is, Group & g)
+{
+    return get(is, g.class_) && get(is, g.id) && get(is, g.bounds);
+}
+
+void put(std::ostream & os, const Inset & i)
+{
+    put(os, i.id);
+    put(os, i.position);
+    put(os, i.size);
+}
+
+bool get(std::istream & is, Inset & i)
+{
+    return get(is, i.id) && get(is, i.position) && get(is, i.size);
+}
+
+void put(std::ostream & os, const LabelledObject & o)
+{
+    put(os, o.pos);
+    put(os, o.mag);
+    put(os, o.label);
+}
+
+bool get(std::istream & is, LabelledObject & o)
+{
+    return get(is, o.pos) && get(is, o.mag) && get(is, o.label);
+}
+
+void put(std::ostream & os, const ProportionalObject & o)
+{
+    put(os, o.pos);
+    put(os, o.radius);
+    put(os, o.label);
+}
+
+bool get(std::istream & is, ProportionalObject & o)
+{
+    return get(is, o.pos) && get(is, o.radius) && get(is, o.label);
+}
+
+void put(std::ostream & os, const Text & t)
+{
+    put(os, t.body);
+    put(os, t.pos);
+}
+
+bool get(std::istream & is, Text & t)
+{
+    return get(is, t.body) && get(is, t.pos);
+}
+
+// Elements without strings go in a single block.
+template <typename T>
+void put_block(std::ostream & os, const ArenaVector<T> & v)
+{
+    put(os, std::uint64_t(v.size()));
+    os.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+bool get_block(std::istream & is, ArenaVector<T> & v)
+{
+    std::uint64_t size;
+    if (! get(is, size) || size > remaining(is) / sizeof(T))
+        return false;
+    v.resize(size);
+    return bool(is.read(reinterpret_cast<char *>(v.data()), size * sizeof(T)));
+}
+
+template <typename T>
+void put_each(std::ostream & os, const ArenaVector<T> & v)
+{
+    put(os, std::uint64_t(v.size()));
+    for (auto const & e : v)
+        put(os, e);
+}
+
+template <typename T>
+bool get_each(std::istream & is, ArenaVector<T> & v)
+{
+    // every element takes a byte at least
+    std::uint64_t size;
+    if (! get(is, size) || size > remaining(is))
+        return false;
+    v.resize(size);
+    for (auto & e : v)
+    {
+        if (! get(is, e))
+            return false;
+    }
+    return true;
+}
+
+}
+
+DisplayList::Layout DisplayList::layout()
+{
+    // byte order, and sizes of everything written in blocks
+    return Layout{{0x01020304, sizeof(std::size_t), sizeof(double), sizeof(Skip), sizeof(Object),
+                sizeof(DirectedObject), sizeof(Rectangle), sizeof(Line), sizeof(BezierPoint)}};
+}
+
+bool DisplayList::consistent() const
+{
+    if (skips_.size() != groups_.size())
+        return false;
+
+    const Position sizes(position());
+    Position next{};
+    // groups and insets open, npos standing for insets
+    const std::size_t npos(std::numeric_limits<std::size_t>::max());
+    std::vector<std::size_t> open;
+    for (std::size_t r(0); r < runs_.size(); ++r)
+    {
+        const Run & run(runs_[r]);
+        const std::size_t k(static_cast<std::size_t>(run.kind));
+        switch (run.kind)
+        {
+            case Kind::BeginGroup:
+            case Kind::BeginInset:
+                if (1 != run.count || next[k] >= sizes[k])
+                    return false;
+                open.push_back(Kind::BeginGroup == run.kind ? next[k] : npos);
+                ++next[k];
+                break;
+            case Kind::End:
+                if (1 != run.count || open.empty())
+                    return false;
+                // skipping a group has to land where painting it would
+                if (npos != open.back() && (skips_[open.back()].run != r || skips_[open.back()].position != next))
+                    return false;
+                open.pop_back();
+                break;
+            default:
+                if (0 == run.count || run.count > sizes[k] - next[k])
+                    return false;
+                next[k] += run.count;
+        }
+    }
+    if (! open.empty() || next != sizes)
+        return false;
+
+    return std::is_sorted(path_ends_.begin(), path_ends_.end())
+        && (path_ends_.empty() ? 0 : path_ends_.back()) == points_.size();
+}
+
+void DisplayList::write(std::ostream & os) const
+{
+    if (! open_.empty())
+        throw InternalError("Writing a display list with groups left open");
+
+    put(os, layout());
+    put(os, clip_);
+    put(os, bounds_);
+    put(os, std::uint64_t(runs_.size()));
+    for (auto const & run : runs_)
+    {
+        put(os, std::uint8_t(run.kind));
+        put(os, std::uint64_t(run.count));
+    }
+    put_block(os, skips_);
+    put_each(os, groups_);
+    put_each(os, insets_);
+    put_block(os, objects_);
+    put_each(os, proportional_objects_);
+    put_each(os, labelled_objects_);
+    put_block(os, directed_objects_);
+    put_block(os, rectangles_);
+    put_block(os, lines_);
+    put_block(os, points_);
+    put_block(os, path_ends_);
+    put_each(os, texts_);
+}
+
+bool DisplayList::read(std::istream & is)
+{
+    Layout written;
+    std::uint64_t runs;
+    if (! get(is, written) || layout() != written || ! get(is, clip_) || ! get(is, bounds_) || ! get(is, runs)
+        || runs > remaining(is) / (sizeof(std::uint8_t) + sizeof(std::uint64_t)))
+        return false;
+
+    open_.clear();
+    runs_.resize(runs);
+    for (auto & run : runs_)
+    {
+        std::uint8_t kind;
+        std::uint64_t count;
+        if (! get(is, kind) || ! get(is, count) || kind >= kinds)
+            return false;
+        run = Run{Kind(kind), count};
+    }
+
+    return get_block(is, skips_) && get_each(is, groups_) && get_each(is, insets_) && get_block(is, objects_)
+        && get_each(is, proportional_objects_) && get_each(is, labelled_objects_)
+        && get_block(is, directed_objects_) && get_block(is, rectangles_) && get_block(is, lines_)
+        && get_block(is, points_) && get_block(is, path_ends_) && get_each(is, texts_)
+        && consistent();
+}
+
+Scene::Scene(Arena & arena)
+    : arena_(arena),
+      scene_(&arena)
+{
+}
+
+void Scene::add(DisplayList && list)
+{
+    scene_.append(std::move(list));
+}
+
+bool Scene::read(const std::string & path, const std::string & key, double margin)
+{
+    std::ifstream f(path, std::ios_base::binary);
+    if (! f)
+        return false;
+    // all of it in memory, for lengths to be checked against
+    std::ostringstream contents;
+    contents << f.rdbuf();
+    std::istringstream is(contents.str());
+
+    char magic[sizeof(scene_magic)];
+    if (! is.read(magic, sizeof(magic)) || 0 != std::memcmp(magic, scene_magic, sizeof(magic)))
+        return false;
+
+    std::string cached_key;
+    double cached_margin;
+    if (! get(is, cached_key) || ! get(is, cached_margin) || cached_key != key || cached_margin < margin)
+        return false;
+
+    // the painter culls what lies within the wider margin
+    DisplayList list(&arena_);
+    if (! list.read(is))
+        return false;
+    scene_ = std::move(list);
+    return true;
+}
+
+void Scene::write(const std::string & path, const std::string & key, double margin) const
+{
+    const std::string tmp(path + ".tmp");
+    {
+        std::ofstream os(tmp, std::ios_base::binary);
+        if (! os)
+            throw std::runtime_error("Can't open scene cache '" + tmp + "' for writing: " + std::strerror(errno));
+
+        os.write(scene_magic, sizeof(scene_magic));
+        put(os, key);
+        put(os, margin);
+        scene_.write(os);
+
+        if (! os.flush())
+            throw std::runtime_error("Writing scene cache '" + tmp + "' failed");
+    }
+
+    if (0 != std::rename(tmp.c_str(), path.c_str()))
+        throw std::runtime_error("Can't move scene cache to '" + path + "': " + std::strerror(errno));
 }
 
 namespace
@@ -46,6 +578,7 @@ namespace
 
 ln_equ_posn convert_to_equ(Coordinates coord, std::pair<double, double> in, ln_lnlat_posn observer, double t)
 {
+    std::lock_guard<std::mutex> lock(libnova_mutex());
     switch(coord)
     {
         case Coordinates::Equatorial:
@@ -68,9 +601,10 @@ ln_equ_posn convert_to_equ(Coordinates coord, std::pair<double, double> in, ln_l
 }
 
 void create_parallel_grid(
-    scene::Group & group, const Grid grid,
+    scene::DisplayList & group, const Grid grid,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t)
+    const SkyCap & region,
+    ln_lnlat_posn observer, double t, Arena & arena)
 {
     for (double y{grid.start.val} ; y <= grid.end.val ; y += grid.step.val)
     {
@@ -79,16 +613,19 @@ void create_parallel_grid(
         {
             path.push_back(convert_to_equ(grid.coordinates, {x, y}, observer, t));
         }
-        auto bezier(create_bezier_from_path(projection, path));
+        if (!may_cross(region, path))
+            continue;
+        auto bezier(create_bezier_from_path(projection, path, &arena));
         for (auto const & b : bezier)
-            group.elements.push_back(scene::Path{b});
+            group.add(b);
     }
 }
 
 void create_meridian_grid(
-    scene::Group & group, const Grid grid,
+    scene::DisplayList & group, const Grid grid,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t)
+    const SkyCap & region,
+    ln_lnlat_posn observer, double t, Arena & arena)
 {
     for (double x{0} ; x <= 360.1 ; x += grid.step.val)
     {
@@ -97,69 +634,84 @@ void create_meridian_grid(
         {
             path.push_back(convert_to_equ(grid.coordinates, {x, y}, observer, t));
         }
-        auto bezier(create_bezier_from_path(projection, path));
+        if (!may_cross(region, path))
+            continue;
+        auto bezier(create_bezier_from_path(projection, path, &arena));
         for (auto const & b : bezier)
-            group.elements.push_back(scene::Path{b});
+            group.add(b);
     }
 }
 
 }
 
-scene::Group build_grid(
+scene::DisplayList build_grid(
     const Grid grid,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t)
+    const SkyCap & region,
+    const CanvasBox & clip,
+    ln_lnlat_posn observer, double t,
+    Arena & arena)
 {
-    scene::Group group{"grid", grid.name, {}};
+    scene::DisplayList group(&arena, clip);
+    group.begin(scene::Group{"grid", grid.name});
     switch (grid.plane)
     {
         case Plane::Parallel:
         {
-            create_parallel_grid(group, grid, projection, observer, t);
+            create_parallel_grid(group, grid, projection, region, observer, t, arena);
             break;
         }
         case Plane::Meridian:
         {
-            create_meridian_grid(group, grid, projection, observer, t);
+            create_meridian_grid(group, grid, projection, region, observer, t, arena);
             break;
         }
     }
+    group.end();
     return group;
 }
 
-scene::Group build_track(
+scene::DisplayList build_track(
     const Track & track,
     const std::shared_ptr<Projection> & projection,
+    const SkyCap & region,
+    const CanvasBox & clip,
     const double epoch,
-    const SolarObjectManager & solar_manager)
+    const SolarObjectManager & solar_manager,
+    Arena & arena)
 {
-    scene::Group group{"track", track.name, {}};
-    auto path(create_path_from_track(projection, track, epoch, solar_manager.get(track.name)));
-    auto beziers(create_bezier_from_path(path, projection->max_distance()));
+    scene::DisplayList group(&arena, clip);
+    group.begin(scene::Group{"track", track.name});
+    auto path(create_path_from_track(projection, region, track, epoch, solar_manager.get(track.name)));
+    auto beziers(create_bezier_from_path(path.data(), path.data() + path.size(), projection->max_distance(), &arena));
     for (auto const & b : beziers)
     {
-        group.elements.push_back(scene::Path{b});
+        group.add(b);
     }
 
     if (path.size() >= 2)
     {
-        auto blind_beziered(interpolate_bezier(path));
+        auto blind_beziered(interpolate_bezier(path.data(), path.data() + path.size(), &arena));
         for (int i(0), i_end(blind_beziered.size());
              i < i_end; i += track.interval_ticks)
         {
             auto p(blind_beziered[i]);
-            group.elements.push_back(scene::DirectedObject{p.p, p.perpendicular});
+            group.add(scene::DirectedObject{p.p, p.perpendicular});
         }
     }
+    group.end();
     return group;
 }
 
-scene::Group build_tick(
+scene::DisplayList build_tick(
     const Tick & tick,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t)
+    const CanvasBox & clip,
+    ln_lnlat_posn observer, double t,
+    Arena & arena)
 {
-    scene::Group group{"tick", tick.name, {}};
+    scene::DisplayList group(&arena, clip);
+    group.begin(scene::Group{"tick", tick.name});
 
     typedef std::pair<double, double> dpair;
     double dpair::* locked;
@@ -187,21 +739,23 @@ scene::Group build_tick(
         dpair pos;
         pos.*locked = tick.base.val;
         pos.*rolling = p;
-        group.elements.push_back(scene::Text{str, projection->project(convert_to_equ(tick.coordinates, pos, observer, t))});
+        group.add(scene::Text{str, projection->project(convert_to_equ(tick.coordinates, pos, observer, t))});
     }
 
+    group.end();
     return group;
 }
 
-scene::Group build_constellations(const std::shared_ptr<Projection> & projection, const double epoch)
+scene::DisplayList build_constellations(const std::shared_ptr<Projection> & projection, const SkyCap & region,
+                                        const CanvasBox & clip, const double epoch, Arena & arena)
 {
     static constexpr double B1875{2405889.258550475};
-    auto pr = [projection,epoch](const ln_equ_posn & in)
-    {
-        return projection->project(convert_epoch(in, B1875, epoch));
-    };
+    const RotationMatrix frame(precession_matrix(B1875, epoch));
 
-    scene::Group group{"constellations", "all", {}};
+    // all visible edges get projected in one batch, ends remembers
+    // where each of them stops
+    std::vector<ln_equ_posn> points, edge_points;
+    std::vector<std::size_t> ends;
     for (auto edge : constellation_edges)
     {
         ln_equ_posn s(edge.first), e(edge.second);
@@ -213,14 +767,30 @@ scene::Group build_constellations(const std::shared_ptr<Projection> & projection
         else
             memp = &ln_equ_posn::ra;
 
-        std::vector<CanvasPoint> path;
+        edge_points.clear();
         for ( ; s.*memp < e.*memp ; s.*memp += 1.)
-            path.push_back(pr(s));
-        path.push_back(pr(e));
-        auto bezier(create_bezier_from_path(path, projection->max_distance()));
+            edge_points.push_back(s);
+        edge_points.push_back(e);
+        if (!may_cross(region, edge_points, frame))
+            continue;
+
+        points.insert(points.end(), edge_points.begin(), edge_points.end());
+        ends.push_back(points.size());
+    }
+    const std::vector<CanvasPoint> projected(projection->project_many(points, frame));
+
+    scene::DisplayList group(&arena, clip);
+    group.begin(scene::Group{"constellations", "all"});
+    std::size_t begin(0);
+    for (auto end : ends)
+    {
+        auto bezier(create_bezier_from_path(projected.data() + begin, projected.data() + end,
+                                            projection->max_distance(), &arena));
+        begin = end;
         for (const auto & b : bezier)
-            group.elements.push_back(scene::Path{b});
+            group.add(b);
     }
+    group.end();
     return group;
 }
 
@@ -23,10 +23,14 @@
 #ifndef ACHARTS_SCENE_STORAGE_HH_
 #define ACHARTS_SCENE_STORAGE_HH_ 1
 
-#include <boost/variant/recursive_variant.hpp>
-#include <deque>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
 #include <libnova/ln_types.h>
+#include <string>
+#include <vector>
 
+#include "arena.hh"
 #include "bezier.hh"
 #include "grid_and_tick.hh"
 #include "projection.hh"
@@ -72,9 +76,10 @@ struct Line
     CanvasPoint start, end;
 };
 
+// Bezier points of a path, inside of the display list holding it.
 struct Path
 {
-    BezierCurve path;
+    const BezierPoint * begin, * end;
 };
 
 struct Text
@@ -83,68 +88,294 @@ struct Text
     CanvasPoint pos;
 };
 
-struct Group;
-
-typedef boost::variant<
-    boost::recursive_wrapper<Group>,
-    Object,
-    ProportionalObject,
-    LabelledObject,
-    DirectedObject,
-    Rectangle,
-    Line,
-    Path,
-    Text
-    > Element;
-
 struct Group
 {
     std::string class_;
     std::string id;
-    std::deque<Element> elements;
+    // Positions of everything within, and control points of paths,
+    // filled in by the display list as they get added.
+    CanvasBox bounds;
+
+    Group()
+        : bounds(CanvasBox::empty())
+    {
+    }
+
+    Group(const std::string & class_, const std::string & id)
+        : class_(class_), id(id), bounds(CanvasBox::empty())
+    {
+    }
+};
+
+// Another viewport, in coordinates relative to its centre at position,
+// clipped to size.
+struct Inset
+{
+    std::string id;
+    CanvasPoint position, size;
+};
+
+/*
+ * Flat list of drawing commands.  Elements of each kind are kept in an
+ * array of their own, in order, and runs records how many of which
+ * kind come next, so a star costs its three doubles.  Groups and
+ * insets are begin and end markers between them.  Painting is a
+ * single sweep over the runs, calling painter's begin(), end() and
+ * operator() for each element.  Arrays are allocated from arena, if
+ * given.
+ *
+ * Nothing lying outside of clip gets in: objects and texts positioned
+ * outside are dropped, paths are cut down to runs of segments crossing
+ * it.  Lists appended are taken as they are.
+ *
+ * Groups get bounds of their contents, an inset counting as its own
+ * rectangle.  When painter's begin() of a group returns false, all
+ * within it is skipped, straight to its end().  Groups opened by a list
+ * have to be closed by it too, before it gets appended.
+ */
+class DisplayList
+{
+public:
+    explicit DisplayList(Arena * arena = nullptr, const CanvasBox & clip = CanvasBox::everything());
+    DisplayList(const DisplayList &) = delete;
+    DisplayList(DisplayList &&) = default;
+    DisplayList & operator=(DisplayList &&) = default;
+
+    void begin(const Group & group);
+    void begin(const Inset & inset);
+    // Closes the innermost group or inset.
+    void end();
+
+    void add(const Object & o);
+    void add(const ProportionalObject & o);
+    void add(const LabelledObject & o);
+    void add(const DirectedObject & o);
+    void add(const Rectangle & r);
+    void add(const Line & l);
+    void add(const BezierCurve & path);
+    void add(const Text & t);
+
+    // Moves commands of rh after those of this list.
+    void append(DisplayList && rh);
+
+    // Of everything outside of groups and insets, and of those.
+    const CanvasBox & bounds() const
+    {
+        return bounds_;
+    }
+
+    // Binary form, tied to the layout of elements in this build.
+    // read() replaces contents of the list, and returns false if is
+    // has been written with another layout, ends early, or doesn't add
+    // up to a list that can be painted.  Lengths are checked against
+    // what's buffered of is, which has to hold all of it, as a
+    // std::istringstream does.
+    void write(std::ostream & os) const;
+    bool read(std::istream & is);
+
+    template <typename Painter>
+    void paint(Painter & painter) const;
+
+private:
+    enum class Kind : unsigned char
+    {
+        BeginGroup,
+        BeginInset,
+        End,
+        Object,
+        ProportionalObject,
+        LabelledObject,
+        DirectedObject,
+        Rectangle,
+        Line,
+        Path,
+        Text
+    };
+
+    static constexpr std::size_t kinds{static_cast<std::size_t>(Kind::Text) + 1};
+    // Index of the next element of each kind.
+    typedef std::array<std::size_t, kinds> Position;
+    // Written ahead of a list, to be read by the same build only.
+    typedef std::array<std::uint32_t, 9> Layout;
+
+    struct Run
+    {
+        Kind kind;
+        std::size_t count;
+    };
+
+    // Where to continue painting after skipping a group, its End run
+    // being painted still.
+    struct Skip
+    {
+        std::size_t run;
+        Position position;
+    };
 
-    Group(const Group &) = delete;
-    Group(Group &&) = default;
+    // Group or inset not closed yet.
+    struct Open
+    {
+        Kind kind;
+        std::size_t index;
+        CanvasBox bounds;
+    };
+
+    static Layout layout();
+    void push(Kind kind);
+    // Whether runs, skips and ends of paths agree with the arrays.
+    bool consistent() const;
+    // Bounds of the innermost group open, or of the list.
+    CanvasBox & innermost();
+    void extend(const CanvasPoint & p);
+    void add_path(const BezierPoint * begin, const BezierPoint * end);
+    Position position() const;
+
+    CanvasBox clip_;
+    CanvasBox bounds_;
+    ArenaVector<Open> open_;
+    // one for each group
+    ArenaVector<Skip> skips_;
+
+    ArenaVector<Run> runs_;
+    ArenaVector<Group> groups_;
+    ArenaVector<Inset> insets_;
+    ArenaVector<Object> objects_;
+    ArenaVector<ProportionalObject> proportional_objects_;
+    ArenaVector<LabelledObject> labelled_objects_;
+    ArenaVector<DirectedObject> directed_objects_;
+    ArenaVector<Rectangle> rectangles_;
+    ArenaVector<Line> lines_;
+    // points of all paths, path_ends_ being where each one stops
+    ArenaVector<BezierPoint> points_;
+    ArenaVector<std::size_t> path_ends_;
+    ArenaVector<Text> texts_;
 };
 
+template <typename Painter>
+void DisplayList::paint(Painter & painter) const
+{
+    Position next{};
+    for (std::size_t r(0); r < runs_.size(); ++r)
+    {
+        const Run & run(runs_[r]);
+        std::size_t & i(next[static_cast<std::size_t>(run.kind)]);
+        const std::size_t end(i + run.count);
+        switch (run.kind)
+        {
+            case Kind::BeginGroup:
+                if (! painter.begin(groups_[i]))
+                {
+                    const Skip & skip(skips_[i]);
+                    r = skip.run;
+                    next = skip.position;
+                    painter.end();
+                    break;
+                }
+                ++i;
+                break;
+            case Kind::BeginInset:
+                painter.begin(insets_[i++]);
+                break;
+            case Kind::End:
+                painter.end();
+                break;
+            case Kind::Object:
+                for ( ; i < end; ++i)
+                    painter(objects_[i]);
+                break;
+            case Kind::ProportionalObject:
+                for ( ; i < end; ++i)
+                    painter(proportional_objects_[i]);
+                break;
+            case Kind::LabelledObject:
+                for ( ; i < end; ++i)
+                    painter(labelled_objects_[i]);
+                break;
+            case Kind::DirectedObject:
+                for ( ; i < end; ++i)
+                    painter(directed_objects_[i]);
+                break;
+            case Kind::Rectangle:
+                for ( ; i < end; ++i)
+                    painter(rectangles_[i]);
+                break;
+            case Kind::Line:
+                for ( ; i < end; ++i)
+                    painter(lines_[i]);
+                break;
+            case Kind::Path:
+                for ( ; i < end; ++i)
+                {
+                    const BezierPoint * points(points_.data());
+                    painter(Path{points + (i ? path_ends_[i - 1] : 0), points + path_ends_[i]});
+                }
+                break;
+            case Kind::Text:
+                for ( ; i < end; ++i)
+                    painter(texts_[i]);
+                break;
+        }
+    }
+}
+
 class Scene
 {
-    const std::shared_ptr<Projection> projection_;
-    Group scene_;
+    Arena & arena_;
+    DisplayList scene_;
 
 public:
-    Scene(const std::shared_ptr<Projection> & projection);
+    explicit Scene(Arena & arena);
     Scene(const Scene &) = delete;
 
-    void add_group(Group && group);
+    void add(DisplayList && list);
 
-    template <typename Visitor>
-    void apply_visitor(Visitor & v)
+    // Scene cached at path, identified by key, and by its canvas
+    // margin.  read() returns false if there is no cache, it's stale,
+    // damaged, written by a build with another layout of the scene, or
+    // it has been built with a margin narrower than margin.
+    bool read(const std::string & path, const std::string & key, double margin);
+    void write(const std::string & path, const std::string & key, double margin) const;
+
+    template <typename Painter>
+    void paint(Painter & painter) const
     {
-        for (auto const & el : scene_.elements)
-            boost::apply_visitor(v, el);
+        scene_.paint(painter);
     }
 };
 
-scene::Group build_grid(
+// Each of below builds a single group, allocated from arena.  Parts of
+// the sky outside of region are left out of them, and so is everything
+// projected outside of clip.
+scene::DisplayList build_grid(
     const Grid grid,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t);
+    const SkyCap & region,
+    const CanvasBox & clip,
+    ln_lnlat_posn observer, double t,
+    Arena & arena);
 
-scene::Group build_track(
+scene::DisplayList build_track(
     const Track & track,
     const std::shared_ptr<Projection> & projection,
+    const SkyCap & region,
+    const CanvasBox & clip,
     const double epoch,
-    const SolarObjectManager & solar_manager);
+    const SolarObjectManager & solar_manager,
+    Arena & arena);
 
-scene::Group build_tick(
+scene::DisplayList build_tick(
     const Tick & tick,
     const std::shared_ptr<Projection> & projection,
-    ln_lnlat_posn observer, double t);
+    const CanvasBox & clip,
+    ln_lnlat_posn observer, double t,
+    Arena & arena);
 
-scene::Group build_constellations(
+scene::DisplayList build_constellations(
     const std::shared_ptr<Projection> & projection,
-    const double epoch);
+    const SkyCap & region,
+    const CanvasBox & clip,
+    const double epoch,
+    Arena & arena);
 
 }
 
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "scene_index.hh"
+
+#include <utility>
+
+namespace scene
+{
+
+namespace
+{
+
+// Collects everything painted, and where it is.
+class Collector
+{
+public:
+    std::vector<SpatialIndex::Item> items;
+    std::vector<CanvasBox> boxes;
+
+    Collector()
+        : offsets_(1)
+    {
+    }
+
+    bool begin(const Group &)
+    {
+        offsets_.push_back(offsets_.back());
+        return true;
+    }
+
+    void begin(const Inset & i)
+    {
+        offsets_.push_back(offsets_.back() + i.position);
+    }
+
+    void end()
+    {
+        offsets_.pop_back();
+    }
+
+    void operator()(const Object & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const ProportionalObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const LabelledObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const DirectedObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const Rectangle &)
+    {
+    }
+
+    void operator()(const Line &)
+    {
+    }
+
+    void operator()(const Path & path)
+    {
+        if (path.begin == path.end)
+            return;
+        CanvasBox box(CanvasBox::empty());
+        for (const BezierPoint * i(path.begin); i != path.end; ++i)
+        {
+            box.extend(i->p);
+            box.extend(i->cm);
+            box.extend(i->cp);
+        }
+        box.start += offsets_.back();
+        box.end += offsets_.back();
+        items.push_back(SpatialIndex::Item{path, offsets_.back()});
+        boxes.push_back(box);
+    }
+
+    void operator()(const Text & t)
+    {
+        add(&t, t.pos);
+    }
+
+private:
+    // position of whatever is being painted within the canvas, nested
+    // insets adding up
+    std::vector<CanvasPoint> offsets_;
+
+    template <typename T>
+    void add(const T * element, CanvasPoint p)
+    {
+        if (p.nan())
+            return;
+        p += offsets_.back();
+        items.push_back(SpatialIndex::Item{element, offsets_.back()});
+        boxes.push_back(CanvasBox{p, p});
+    }
+};
+
+// Grid of everything painted by scene, items of which go to items.
+CanvasGrid indexed(const Scene & scene, const CanvasBox & area, std::vector<SpatialIndex::Item> & items)
+{
+    Collector collector;
+    scene.paint(collector);
+    items = std::move(collector.items);
+
+    CanvasGrid grid(area, CanvasGrid::cell_for(area, collector.boxes.size()));
+    for (const CanvasBox & box : collector.boxes)
+        grid.insert(box);
+    return grid;
+}
+
+}
+
+SpatialIndex::SpatialIndex(const Scene & scene, const CanvasBox & area)
+    : grid_(indexed(scene, area, items_))
+{
+}
+
+}
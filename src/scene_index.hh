@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_SCENE_INDEX_HH
+#define ACHARTS_SCENE_INDEX_HH 1
+
+#include <boost/variant/variant.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "canvas_grid.hh"
+#include "scene.hh"
+
+namespace scene
+{
+
+/*
+ * Where elements of a finished scene got drawn, for looking up what
+ * lies within a part of the canvas, or closest to a point, without
+ * going through all of it.  Objects and texts are indexed as points,
+ * paths by bounds of their points and control points, and contents of
+ * insets where the inset is placed.  Rectangles and lines, which only
+ * make up backgrounds and frames, are left out.  Items refer to
+ * elements within the scene, which has to outlive the index and stay
+ * as it is.
+ */
+class SpatialIndex
+{
+public:
+    // A path refers to points held by the scene.
+    typedef boost::variant<const Object *, const ProportionalObject *, const LabelledObject *,
+                           const DirectedObject *, Path, const Text *> Element;
+
+    // Coordinates of element are relative to offset, where the inset
+    // holding it is placed, if any.
+    struct Item
+    {
+        Element element;
+        CanvasPoint offset;
+    };
+
+    // Anything outside of area is indexed still, just less efficiently.
+    SpatialIndex(const Scene & scene, const CanvasBox & area);
+
+    // Items, in order of painting.
+    const std::vector<Item> & items() const
+    {
+        return items_;
+    }
+
+    // Where item is on the canvas.
+    const CanvasBox & box(const Item & item) const
+    {
+        return grid_.box(&item - items_.data());
+    }
+
+    // Calls f(item) once for each item overlapping range.
+    template <typename F>
+    void query(const CanvasBox & range, F f) const
+    {
+        grid_.query(range, [this, &f](std::size_t i)
+                    {
+                        f(items_[i]);
+                    });
+    }
+
+    // Item closest to p, or nullptr if there are none.
+    const Item * nearest(const CanvasPoint & p) const
+    {
+        const std::size_t i(grid_.nearest(p));
+        return CanvasGrid::npos == i ? nullptr : &items_[i];
+    }
+
+private:
+    std::vector<Item> items_;
+    CanvasGrid grid_;
+};
+
+}
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "scene_index.hh"
+
+/*
+ * Fills a scene with objects, texts and paths of every kind, some
+ * within an inset and some off the area indexed, and checks range and
+ * nearest queries of its index against going through everything the
+ * scene paints.
+ */
+
+namespace
+{
+
+const CanvasBox area{CanvasPoint(-150., -100.), CanvasPoint(150., 100.)};
+
+// Identifies an element, for comparing what the index finds with what
+// got painted.
+class Identity : public boost::static_visitor<const void *>
+{
+public:
+    const void * operator()(const scene::Path & path) const
+    {
+        return path.begin;
+    }
+
+    template <typename Element>
+    const void * operator()(const Element * element) const
+    {
+        return element;
+    }
+};
+
+struct Painted
+{
+    const void * identity;
+    CanvasBox box;
+};
+
+// Everything painted, and where on the canvas, brute force.
+class Everything
+{
+public:
+    std::vector<Painted> painted;
+
+    Everything()
+        : offsets_(1)
+    {
+    }
+
+    bool begin(const scene::Group &)
+    {
+        offsets_.push_back(offsets_.back());
+        return true;
+    }
+
+    void begin(const scene::Inset & i)
+    {
+        offsets_.push_back(offsets_.back() + i.position);
+    }
+
+    void end()
+    {
+        offsets_.pop_back();
+    }
+
+    void operator()(const scene::Object & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const scene::ProportionalObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const scene::LabelledObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const scene::DirectedObject & o)
+    {
+        add(&o, o.pos);
+    }
+
+    void operator()(const scene::Rectangle &)
+    {
+    }
+
+    void operator()(const scene::Line &)
+    {
+    }
+
+    void operator()(const scene::Path & path)
+    {
+        CanvasBox box(CanvasBox::empty());
+        for (const BezierPoint * i(path.begin); i != path.end; ++i)
+        {
+            box.extend(i->p + offsets_.back());
+            box.extend(i->cm + offsets_.back());
+            box.extend(i->cp + offsets_.back());
+        }
+        painted.push_back(Painted{path.begin, box});
+    }
+
+    void operator()(const scene::Text & t)
+    {
+        add(&t, t.pos);
+    }
+
+private:
+    std::vector<CanvasPoint> offsets_;
+
+    void add(const void * identity, const CanvasPoint & p)
+    {
+        painted.push_back(Painted{identity, CanvasBox{p + offsets_.back(), p + offsets_.back()}});
+    }
+};
+
+double distance(const CanvasPoint & p, const CanvasBox & box)
+{
+    const double dx(std::max({box.start.x - p.x, 0., p.x - box.end.x})),
+        dy(std::max({box.start.y - p.y, 0., p.y - box.end.y}));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Elements spread over twice the area indexed, a quarter of them in an
+// inset.
+void fill(scene::DisplayList & list, std::mt19937 & random)
+{
+    std::uniform_real_distribution<double> x(2. * area.start.x, 2. * area.end.x), y(2. * area.start.y, 2. * area.end.y);
+    list.begin(scene::Group{"test", "test"});
+    for (int inset(0); inset < 2; ++inset)
+    {
+        if (inset)
+            list.begin(scene::Inset{"inset", CanvasPoint(40., -30.), CanvasPoint(100., 80.)});
+        const int count(inset ? 250 : 750);
+        for (int i(0); i < count; ++i)
+        {
+            const CanvasPoint p(x(random), y(random));
+            switch (i % 6)
+            {
+                case 0:
+                    list.add(scene::Object{p, 3.});
+                    break;
+                case 1:
+                    list.add(scene::ProportionalObject{p, 2., "Planet"});
+                    break;
+                case 2:
+                    list.add(scene::LabelledObject{p, 1., "Star"});
+                    break;
+                case 3:
+                    list.add(scene::DirectedObject{p, CanvasPoint(1., 0.)});
+                    break;
+                case 4:
+                    list.add(scene::Text{"Text", p});
+                    break;
+                case 5:
+                {
+                    const CanvasPoint points[]{p, p + CanvasPoint(x(random) / 20., y(random) / 20.),
+                                               p + CanvasPoint(x(random) / 10., y(random) / 10.)};
+                    list.add(interpolate_bezier(points, points + 3));
+                    break;
+                }
+            }
+        }
+        if (inset)
+            list.end();
+    }
+    list.end();
+}
+
+}
+
+int main()
+{
+    std::mt19937 random(49);
+    Arena arena;
+    scene::Scene scene(arena);
+    scene::DisplayList list(&arena);
+    fill(list, random);
+    scene.add(std::move(list));
+
+    const scene::SpatialIndex index(scene, area);
+    Everything everything;
+    scene.paint(everything);
+
+    int failures(0);
+    if (index.items().size() != everything.painted.size())
+    {
+        std::cerr << "Index holds " << index.items().size() << " items of " << everything.painted.size()
+                  << std::endl;
+        ++failures;
+    }
+
+    std::uniform_real_distribution<double> x(2.5 * area.start.x, 2.5 * area.end.x),
+        y(2.5 * area.start.y, 2.5 * area.end.y), size(0., 60.);
+    for (int i(0); i < 1000; ++i)
+    {
+        const CanvasPoint p(x(random), y(random));
+        const CanvasBox range{p, p + CanvasPoint(size(random), size(random))};
+
+        std::vector<const void *> found, expected;
+        index.query(range, [&](const scene::SpatialIndex::Item & item)
+                    {
+                        found.push_back(boost::apply_visitor(Identity(), item.element));
+                        if (! index.box(item).overlaps(range))
+                            ++failures;
+                    });
+        for (const Painted & painted : everything.painted)
+        {
+            if (painted.box.overlaps(range))
+                expected.push_back(painted.identity);
+        }
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        if (found != expected)
+        {
+            std::cerr << "Range " << i << " finds " << found.size() << " items of " << expected.size()
+                      << std::endl;
+            ++failures;
+        }
+
+        const scene::SpatialIndex::Item * nearest(index.nearest(p));
+        double closest(INFINITY);
+        for (const Painted & painted : everything.painted)
+            closest = std::min(closest, distance(p, painted.box));
+        if (! nearest || distance(p, index.box(*nearest)) != closest)
+        {
+            std::cerr << "Nearest to point " << i << " is "
+                      << (nearest ? distance(p, index.box(*nearest)) : INFINITY) << " away, not " << closest
+                      << std::endl;
+            ++failures;
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
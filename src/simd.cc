@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "simd.hh"
+
+#include <initializer_list>
+
+namespace
+{
+
+bool cpu_supports(simd::Isa isa)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    switch (isa)
+    {
+        case simd::Isa::Scalar:
+            return true;
+        case simd::Isa::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case simd::Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case simd::Isa::AVX512:
+            return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return simd::Isa::Scalar == isa;
+#endif
+}
+
+}
+
+simd::Isa simd::detect_isa()
+{
+    for (auto isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2})
+    {
+        if (kernels(isa) && cpu_supports(isa))
+            return isa;
+    }
+    return Isa::Scalar;
+}
+
+const char * simd::isa_name(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::Scalar:
+            return "scalar";
+        case Isa::SSE2:
+            return "SSE2";
+        case Isa::AVX2:
+            return "AVX2";
+        case Isa::AVX512:
+            return "AVX-512";
+    }
+    return "unknown";
+}
+
+const simd::Kernels * simd::kernels(Isa isa, Precision precision)
+{
+    const bool single(Precision::Single == precision);
+    switch (isa)
+    {
+        case Isa::Scalar:
+            return nullptr;
+        case Isa::SSE2:
+#ifdef HAVE_SSE2
+            return single ? &kernels_sse2_single : &kernels_sse2;
+#else
+            return nullptr;
+#endif
+        case Isa::AVX2:
+#ifdef HAVE_AVX2
+            return single ? &kernels_avx2_single : &kernels_avx2;
+#else
+            return nullptr;
+#endif
+        case Isa::AVX512:
+#ifdef HAVE_AVX512
+            return single ? &kernels_avx512_single : &kernels_avx512;
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_SIMD_HH
+#define ACHARTS_SIMD_HH 1
+
+#include <cstddef>
+
+#include "canvas.hh"
+#include "sky_vector.hh"
+
+namespace simd
+{
+
+// Instruction sets the projection kernels are built for, narrowest first.
+enum class Isa
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Precision of arithmetic inside vectorised kernels.  Inputs and
+// outputs are double either way; single precision doubles the number
+// of lanes.
+enum class Precision
+{
+    Double,
+    Single
+};
+
+// Widest instruction set that was compiled in and the CPU supports.
+Isa detect_isa();
+const char * isa_name(Isa isa);
+
+/*
+ * Everything a projection applies to a position besides its own
+ * distortion: the rotation of equatorial unit vectors into the
+ * projection's frame, the linear map onto the canvas, and an offset
+ * of latitude for cylindrical projections.
+ */
+struct FrameParams
+{
+    double matrix[3][3];
+    double post[2][2];
+    double lat_offset;
+};
+
+// Positions given as degrees.
+typedef void (*EquatorialKernel)(const FrameParams & params,
+                                 const double * ra, const double * dec, std::size_t n, CanvasPoint * out);
+// Positions given as unit vectors.
+typedef void (*VectorKernel)(const FrameParams & params,
+                             const SkyVector * pos, std::size_t n, CanvasPoint * out);
+
+// Map projections having vectorised kernels.
+enum class Map
+{
+    AzimuthalEquidistant,
+    AzimuthalEquidistantSeries,
+    Stereographic,
+    Gnomonic,
+    Orthographic,
+    LambertAzimuthalEqualArea,
+    CylindricalEquidistant,
+    Mollweide,
+    HammerAitoff
+};
+const std::size_t map_count{9};
+
+// Visibility limits shared by the scalar and vectorised kernels.  The
+// antipode of an azimuthal projection's centre has no single position;
+// gnomonic projection shows only positions closer than 85 degrees to
+// the centre, orthographic one only the hemisphere facing the viewer.
+const double antipode_distance{0.0001};
+const double antipode_min_z{-0.999999995};
+const double gnomonic_min_z{0.0871557427476582};
+// The azimuthal equidistant series, asin(s) / s up to s^8, is used
+// where the squared sine of distance from the centre is at most
+// series_max_s2; its relative error there is below series_error.
+const double series_max_s2{0.01};
+const double series_error{2.3e-12};
+// Mollweide's auxiliary angle is found with Newton's method, starting
+// from its expansion at the pole above this sine of latitude.
+const double mollweide_polar_z{0.8};
+const int mollweide_iterations{4};
+
+/*
+ * Vectorised projections, indexed by Map.  Sine, cosine and arc
+ * tangent are evaluated with Cephes' polynomials, which are accurate
+ * to a few ulp over the range of angles used here.
+ */
+struct Kernels
+{
+    EquatorialKernel equatorial[map_count];
+    VectorKernel vectors[map_count];
+};
+
+// Returns nullptr for Isa::Scalar and instruction sets not compiled in.
+const Kernels * kernels(Isa isa, Precision precision = Precision::Double);
+
+// Defined by simd_*.cc, each built with flags for its instruction set.
+extern const Kernels kernels_sse2;
+extern const Kernels kernels_sse2_single;
+extern const Kernels kernels_avx2;
+extern const Kernels kernels_avx2_single;
+extern const Kernels kernels_avx512;
+extern const Kernels kernels_avx512_single;
+
+}
+
+#endif
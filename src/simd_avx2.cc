@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "simd.hh"
+
+#include <immintrin.h>
+
+namespace
+{
+
+struct Avx2
+{
+    typedef __m256d type;
+    typedef __m256d mask;
+    static const std::size_t width{4};
+
+    static type set1(double d) { return _mm256_set1_pd(d); }
+    static type load(const double * p) { return _mm256_loadu_pd(p); }
+    static void store(double * p, type v) { _mm256_storeu_pd(p, v); }
+
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm256_div_pd(a, b); }
+    static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+    static type min(type a, type b) { return _mm256_min_pd(a, b); }
+    static type max(type a, type b) { return _mm256_max_pd(a, b); }
+    static type abs(type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a); }
+    static type trunc(type a) { return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+    static mask lt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static mask gt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static mask ge(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static mask eq(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static mask mask_or(mask a, mask b) { return _mm256_or_pd(a, b); }
+    static bool any(mask m) { return 0 != _mm256_movemask_pd(m); }
+    static type select(mask m, type a, type b) { return _mm256_blendv_pd(b, a, m); }
+};
+
+// Single precision, converting from and to double on loads and stores.
+struct Avx2Float
+{
+    typedef __m256 type;
+    typedef __m256 mask;
+    static const std::size_t width{8};
+
+    static type set1(double d) { return _mm256_set1_ps(float(d)); }
+    static type load(const double * p)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(p))),
+                                    _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), 1);
+    }
+    static void store(double * p, type v)
+    {
+        _mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        _mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm256_div_ps(a, b); }
+    static type sqrt(type a) { return _mm256_sqrt_ps(a); }
+    static type min(type a, type b) { return _mm256_min_ps(a, b); }
+    static type max(type a, type b) { return _mm256_max_ps(a, b); }
+    static type abs(type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+    static type trunc(type a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+    static mask lt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static mask gt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static mask ge(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static mask eq(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static mask mask_or(mask a, mask b) { return _mm256_or_ps(a, b); }
+    static bool any(mask m) { return 0 != _mm256_movemask_ps(m); }
+    static type select(mask m, type a, type b) { return _mm256_blendv_ps(b, a, m); }
+};
+
+}
+
+#include "simd_kernels.hh"
+
+// constant initialised, nothing here may run before the CPU is checked
+const simd::Kernels simd::kernels_avx2 = ACHARTS_SIMD_KERNELS(Avx2);
+const simd::Kernels simd::kernels_avx2_single = ACHARTS_SIMD_KERNELS(Avx2Float);
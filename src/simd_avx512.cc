@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "simd.hh"
+
+#include <immintrin.h>
+
+namespace
+{
+
+struct Avx512
+{
+    typedef __m512d type;
+    typedef __mmask8 mask;
+    static const std::size_t width{8};
+
+    static type set1(double d) { return _mm512_set1_pd(d); }
+    static type load(const double * p) { return _mm512_loadu_pd(p); }
+    static void store(double * p, type v) { _mm512_storeu_pd(p, v); }
+
+    static type add(type a, type b) { return _mm512_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm512_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm512_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm512_div_pd(a, b); }
+    static type sqrt(type a) { return _mm512_sqrt_pd(a); }
+    static type min(type a, type b) { return _mm512_min_pd(a, b); }
+    static type max(type a, type b) { return _mm512_max_pd(a, b); }
+    // AVX-512F lacks floating point bitwise operations
+    static type abs(type a)
+    {
+        return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),
+                                                    _mm512_set1_epi64(0x7fffffffffffffffLL)));
+    }
+    static type trunc(type a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+    static mask lt(type a, type b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static mask gt(type a, type b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static mask ge(type a, type b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+    static mask eq(type a, type b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static mask mask_or(mask a, mask b) { return a | b; }
+    static bool any(mask m) { return 0 != m; }
+    static type select(mask m, type a, type b) { return _mm512_mask_blend_pd(m, b, a); }
+};
+
+// Single precision, converting from and to double on loads and stores.
+struct Avx512Float
+{
+    typedef __m512 type;
+    typedef __mmask16 mask;
+    static const std::size_t width{16};
+
+    static type set1(double d) { return _mm512_set1_ps(float(d)); }
+    // AVX-512F can insert halves of 64 bit elements only
+    static type load(const double * p)
+    {
+        const __m512d low(_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(_mm512_loadu_pd(p)))));
+        const __m256d high(_mm256_castps_pd(_mm512_cvtpd_ps(_mm512_loadu_pd(p + 8))));
+        return _mm512_castpd_ps(_mm512_insertf64x4(low, high, 1));
+    }
+    static void store(double * p, type v)
+    {
+        _mm512_storeu_pd(p, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+        _mm512_storeu_pd(p + 8, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+    }
+
+    static type add(type a, type b) { return _mm512_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm512_div_ps(a, b); }
+    static type sqrt(type a) { return _mm512_sqrt_ps(a); }
+    static type min(type a, type b) { return _mm512_min_ps(a, b); }
+    static type max(type a, type b) { return _mm512_max_ps(a, b); }
+    static type abs(type a)
+    {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+    }
+    static type trunc(type a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+    static mask lt(type a, type b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static mask gt(type a, type b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static mask ge(type a, type b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static mask eq(type a, type b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static mask mask_or(mask a, mask b) { return a | b; }
+    static bool any(mask m) { return 0 != m; }
+    static type select(mask m, type a, type b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+
+}
+
+#include "simd_kernels.hh"
+
+// constant initialised, nothing here may run before the CPU is checked
+const simd::Kernels simd::kernels_avx512 = ACHARTS_SIMD_KERNELS(Avx512);
+const simd::Kernels simd::kernels_avx512_single = ACHARTS_SIMD_KERNELS(Avx512Float);
@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_SIMD_KERNELS_HH
+#define ACHARTS_SIMD_KERNELS_HH 1
+
+/*
+ * Projection kernels written once against a vector type V, which
+ * every simd_*.cc instantiates with its own instruction set.
+ *
+ * Those files are compiled with flags enabling instructions the CPU
+ * may lack, so nothing in here may end up as an out of line function
+ * the linker could share with the rest of the program: everything
+ * lives in an anonymous namespace and uses only V's operations.
+ */
+
+#include <cmath>
+#include <cstddef>
+
+#include "simd.hh"
+
+namespace
+{
+
+const double pi{3.14159265358979323846};
+const double deg_to_rad{pi / 180.};
+
+template <typename V>
+struct Math
+{
+    typedef typename V::type vd;
+    typedef typename V::mask mask;
+
+    static vd poly(vd x, double c0, double c1, double c2, double c3, double c4, double c5)
+    {
+        vd r(V::add(V::mul(V::set1(c0), x), V::set1(c1)));
+        r = V::add(V::mul(r, x), V::set1(c2));
+        r = V::add(V::mul(r, x), V::set1(c3));
+        r = V::add(V::mul(r, x), V::set1(c4));
+        return V::add(V::mul(r, x), V::set1(c5));
+    }
+
+    static vd negate_if(mask m, vd x)
+    {
+        return V::select(m, V::sub(V::set1(0.), x), x);
+    }
+
+    // Cephes' sin and cos, reduced by multiples of pi/4.
+    static void sincos(vd x, vd & s, vd & c)
+    {
+        const vd ax(V::abs(x));
+        vd j(V::trunc(V::mul(ax, V::set1(4. / pi))));
+        // odd octants are mapped onto the following even ones
+        j = V::add(j, V::sub(j, V::mul(V::set1(2.), V::trunc(V::mul(j, V::set1(.5))))));
+        const vd q(V::sub(j, V::mul(V::set1(8.), V::trunc(V::mul(j, V::set1(.125))))));
+
+        vd z(V::sub(ax, V::mul(j, V::set1(7.85398125648498535156E-1))));
+        z = V::sub(z, V::mul(j, V::set1(3.77489470793079817668E-8)));
+        z = V::sub(z, V::mul(j, V::set1(2.69515142907905952645E-15)));
+        const vd zz(V::mul(z, z));
+
+        const vd ps(V::add(z, V::mul(V::mul(z, zz),
+                                     poly(zz, 1.58962301576546568060E-10, -2.50507477628578072866E-8,
+                                          2.75573136213857245213E-6, -1.98412698295895385996E-4,
+                                          8.33333333332211858878E-3, -1.66666666666666307295E-1))));
+        const vd pc(V::add(V::sub(V::set1(1.), V::mul(V::set1(.5), zz)),
+                           V::mul(V::mul(zz, zz),
+                                  poly(zz, -1.13585365213876817300E-11, 2.08757008419747316778E-9,
+                                       -2.75573141792967388112E-7, 2.48015872888517045348E-5,
+                                       -1.38888888888730564116E-3, 4.16666666666665929218E-2))));
+
+        const mask q2(V::eq(q, V::set1(2.))), q4(V::eq(q, V::set1(4.))), q6(V::eq(q, V::set1(6.)));
+        const mask swap(V::mask_or(q2, q6));
+        s = negate_if(V::gt(q, V::set1(3.)), V::select(swap, pc, ps));
+        s = negate_if(V::lt(x, V::set1(0.)), s);
+        c = negate_if(V::mask_or(q2, q4), V::select(swap, ps, pc));
+    }
+
+    // Cephes' atan, extended to all quadrants.
+    static vd atan2(vd y, vd x)
+    {
+        const vd ay(V::abs(y)), ax(V::abs(x));
+        const vd mx(V::max(ax, ay));
+        vd t(V::select(V::eq(mx, V::set1(0.)), V::set1(0.), V::div(V::min(ax, ay), mx)));
+
+        const mask big(V::gt(t, V::set1(.66)));
+        t = V::select(big, V::div(V::sub(t, V::set1(1.)), V::add(t, V::set1(1.))), t);
+        const vd z(V::mul(t, t));
+
+        vd p(V::add(V::mul(V::set1(-8.750608600031904122785E-1), z), V::set1(-1.615753718733365076637E1)));
+        p = V::add(V::mul(p, z), V::set1(-7.500855792314704667340E1));
+        p = V::add(V::mul(p, z), V::set1(-1.228866684490136173410E2));
+        p = V::add(V::mul(p, z), V::set1(-6.485021904942025371773E1));
+        vd q(V::add(z, V::set1(2.485846490142306297962E1)));
+        q = V::add(V::mul(q, z), V::set1(1.650270098316988542046E2));
+        q = V::add(V::mul(q, z), V::set1(4.328810604912902668951E2));
+        q = V::add(V::mul(q, z), V::set1(4.853903996359136964868E2));
+        q = V::add(V::mul(q, z), V::set1(1.945506571482613964425E2));
+
+        vd r(V::add(t, V::mul(V::mul(t, z), V::div(p, q))));
+        r = V::add(r, V::select(big, V::set1(pi / 4. + .5 * 6.123233995736765886130E-17), V::set1(0.)));
+
+        r = V::select(V::gt(ay, ax), V::sub(V::set1(pi / 2.), r), r);
+        r = V::select(V::lt(x, V::set1(0.)), V::sub(V::set1(pi), r), r);
+        return negate_if(V::lt(y, V::set1(0.)), r);
+    }
+};
+
+template <typename V>
+struct Frame
+{
+    typedef typename V::type vd;
+    typedef Math<V> M;
+
+    static void from_equatorial(vd ra, vd dec, vd & x, vd & y, vd & z)
+    {
+        vd sd, cd, sr, cr;
+        M::sincos(V::mul(dec, V::set1(deg_to_rad)), sd, cd);
+        M::sincos(V::mul(ra, V::set1(deg_to_rad)), sr, cr);
+        x = V::mul(cd, cr);
+        y = V::mul(cd, sr);
+        z = sd;
+    }
+
+    static void rotate(const simd::FrameParams & p, vd & x, vd & y, vd & z)
+    {
+        vd r[3];
+        for (int i(0); i < 3; ++i)
+            r[i] = V::add(V::add(V::mul(V::set1(p.matrix[i][0]), x), V::mul(V::set1(p.matrix[i][1]), y)),
+                          V::mul(V::set1(p.matrix[i][2]), z));
+        x = r[0];
+        y = r[1];
+        z = r[2];
+    }
+
+    static void post(const simd::FrameParams & p, vd x, vd y, double * out_x, double * out_y)
+    {
+        V::store(out_x, V::add(V::mul(V::set1(p.post[0][0]), x), V::mul(V::set1(p.post[0][1]), y)));
+        V::store(out_y, V::add(V::mul(V::set1(p.post[1][0]), x), V::mul(V::set1(p.post[1][1]), y)));
+    }
+};
+
+// Distortions of vectors already rotated into the projection's frame.
+// Azimuthal ones have the centre on z, and scale x and y by k.
+template <typename V>
+struct Azimuthal
+{
+    typedef typename V::type vd;
+    typedef typename V::mask mask;
+
+    // Positions outside of visible are dropped as NaN.
+    static void finish(const simd::FrameParams & p, vd x, vd y, vd k, mask visible, double * out_x, double * out_y)
+    {
+        k = V::select(visible, k, V::set1(NAN));
+        Frame<V>::post(p, V::mul(k, x), V::mul(k, y), out_x, out_y);
+    }
+
+    // Everything but a small neighbourhood of the antipode, which has no
+    // single position.
+    static mask but_antipode(vd z)
+    {
+        return V::gt(z, V::set1(simd::antipode_min_z));
+    }
+};
+
+template <typename V>
+struct AzimuthalEquidistant
+{
+    typedef typename V::type vd;
+    typedef Math<V> M;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        // angular distance from the centre, atan2 keeps it precise
+        // close to the centre, where acos(z) wouldn't
+        const vd sinc(V::sqrt(V::add(V::mul(x, x), V::mul(y, y))));
+        const vd c(M::atan2(sinc, z));
+        const vd k(V::select(V::eq(sinc, V::set1(0.)), V::set1(1.), V::div(c, sinc)));
+        Azimuthal<V>::finish(p, x, y, k, V::ge(V::abs(V::sub(c, V::set1(pi))), V::set1(simd::antipode_distance)),
+                             out_x, out_y);
+    }
+};
+
+// Close to the centre, c / sin(c) is a polynomial in sin(c)^2, so
+// neither arc tangent nor division is needed.  Vectors with any lane
+// farther away compute the exact path too, and take it for those lanes
+// only, so each lane comes out the same whatever its neighbours.
+template <typename V>
+struct AzimuthalEquidistantSeries
+{
+    typedef typename V::type vd;
+    typedef typename V::mask mask;
+    typedef Math<V> M;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        const vd s2(V::add(V::mul(x, x), V::mul(y, y)));
+        vd k(V::add(V::mul(V::set1(35. / 1152.), s2), V::set1(5. / 112.)));
+        k = V::add(V::mul(k, s2), V::set1(3. / 40.));
+        k = V::add(V::mul(k, s2), V::set1(1. / 6.));
+        k = V::add(V::mul(k, s2), V::set1(1.));
+
+        const mask far(V::mask_or(V::gt(s2, V::set1(simd::series_max_s2)), V::lt(z, V::set1(0.))));
+        if (V::any(far))
+        {
+            const vd sinc(V::sqrt(s2));
+            const vd c(M::atan2(sinc, z));
+            const vd exact(V::select(V::eq(sinc, V::set1(0.)), V::set1(1.), V::div(c, sinc)));
+            Azimuthal<V>::finish(p, x, y, V::select(far, exact, k),
+                                 V::ge(V::abs(V::sub(c, V::set1(pi))), V::set1(simd::antipode_distance)),
+                                 out_x, out_y);
+            return;
+        }
+        Frame<V>::post(p, V::mul(k, x), V::mul(k, y), out_x, out_y);
+    }
+};
+
+template <typename V>
+struct Stereographic
+{
+    typedef typename V::type vd;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        const vd k(V::div(V::set1(2.), V::add(V::set1(1.), z)));
+        Azimuthal<V>::finish(p, x, y, k, Azimuthal<V>::but_antipode(z), out_x, out_y);
+    }
+};
+
+template <typename V>
+struct Gnomonic
+{
+    typedef typename V::type vd;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        Azimuthal<V>::finish(p, x, y, V::div(V::set1(1.), z), V::gt(z, V::set1(simd::gnomonic_min_z)), out_x, out_y);
+    }
+};
+
+template <typename V>
+struct Orthographic
+{
+    typedef typename V::type vd;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        Azimuthal<V>::finish(p, x, y, V::set1(1.), V::ge(z, V::set1(0.)), out_x, out_y);
+    }
+};
+
+template <typename V>
+struct LambertAzimuthalEqualArea
+{
+    typedef typename V::type vd;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        const vd k(V::sqrt(V::div(V::set1(2.), V::add(V::set1(1.), z))));
+        Azimuthal<V>::finish(p, x, y, k, Azimuthal<V>::but_antipode(z), out_x, out_y);
+    }
+};
+
+// Cylindrical and pseudo-cylindrical ones have the centre's meridian on
+// longitude 0.
+template <typename V>
+struct CylindricalEquidistant
+{
+    typedef typename V::type vd;
+    typedef Math<V> M;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        const vd lon(M::atan2(y, x));
+        const vd lat(V::sub(M::atan2(z, V::sqrt(V::add(V::mul(x, x), V::mul(y, y)))), V::set1(p.lat_offset)));
+        Frame<V>::post(p, lon, lat, out_x, out_y);
+    }
+};
+
+template <typename V>
+struct Mollweide
+{
+    typedef typename V::type vd;
+    typedef typename V::mask mask;
+    typedef Math<V> M;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        const vd lon(M::atan2(y, x));
+
+        // Newton's method for t + sin t = pi sin(lat), t being twice the
+        // auxiliary angle, starting close to the poles from the cube
+        // root of its Taylor expansion there
+        const vd rho2(V::add(V::mul(x, x), V::mul(y, y)));
+        const vd az(V::abs(z));
+        const vd cube(V::div(V::mul(V::set1(6. * pi), rho2), V::add(V::set1(1.), az)));
+        double lanes[V::width];
+        V::store(lanes, cube);
+        // cube is 6 pi (1 - |z|), so only lanes close to the poles need it
+        for (std::size_t j(0); j < V::width; ++j)
+            lanes[j] = lanes[j] < 6. * pi * (1. - simd::mollweide_polar_z) ? cbrt(lanes[j]) : 0.;
+        const vd polar(M::negate_if(V::lt(z, V::set1(0.)), V::sub(V::set1(pi), V::load(lanes))));
+
+        const vd k(V::mul(V::set1(pi), z));
+        vd t(V::select(V::gt(az, V::set1(simd::mollweide_polar_z)), polar, V::mul(V::set1(.5), k)));
+        for (int i(0); i < simd::mollweide_iterations; ++i)
+        {
+            vd s, c;
+            M::sincos(t, s, c);
+            const vd d(V::add(V::set1(1.), c));
+            const vd step(V::div(V::sub(V::add(t, s), k), d));
+            t = V::sub(t, V::select(V::gt(d, V::set1(0.)), step, V::set1(0.)));
+        }
+
+        vd s, c;
+        M::sincos(V::mul(V::set1(.5), t), s, c);
+        Frame<V>::post(p, V::mul(lon, c), V::mul(V::set1(pi / 2.), s), out_x, out_y);
+    }
+};
+
+template <typename V>
+struct HammerAitoff
+{
+    typedef typename V::type vd;
+    typedef Math<V> M;
+
+    static void project(const simd::FrameParams & p, vd x, vd y, vd z, double * out_x, double * out_y)
+    {
+        // cos(lat) cos(lon / 2) and cos(lat) sin(lon / 2), by half angle
+        // formulas; the smaller one from their product rho y / 2, as
+        // rho - |x| cancels close to the centre and its antipode
+        const vd rho(V::sqrt(V::add(V::mul(x, x), V::mul(y, y))));
+        const vd big(V::sqrt(V::mul(V::set1(.5), V::mul(rho, V::add(rho, V::abs(x))))));
+        const vd small(V::select(V::gt(big, V::set1(0.)),
+                                 V::div(V::mul(V::set1(.5), V::mul(rho, V::abs(y))), big), V::set1(0.)));
+        const typename V::mask front(V::ge(x, V::set1(0.)));
+        const vd ch(V::select(front, big, small));
+        const vd sh(M::negate_if(V::lt(y, V::set1(0.)), V::select(front, small, big)));
+        const vd w(V::div(V::set1(pi), V::sqrt(V::add(V::set1(1.), ch))));
+        Frame<V>::post(p, V::mul(w, sh), V::mul(V::mul(V::set1(.5), w), z), out_x, out_y);
+    }
+};
+
+template <typename V>
+void store(const double * x, const double * y, std::size_t count, CanvasPoint * out)
+{
+    for (std::size_t j(0); j < count; ++j)
+    {
+        out[j].x = x[j];
+        out[j].y = y[j];
+    }
+}
+
+template <typename V, typename Projection>
+void project_equatorial(const simd::FrameParams & params,
+                        const double * ra, const double * dec, std::size_t n, CanvasPoint * out)
+{
+    const std::size_t w(V::width);
+    double px[V::width], py[V::width];
+    typename V::type x, y, z;
+    std::size_t i(0);
+    for (; i + w <= n; i += w)
+    {
+        Frame<V>::from_equatorial(V::load(ra + i), V::load(dec + i), x, y, z);
+        Frame<V>::rotate(params, x, y, z);
+        Projection::project(params, x, y, z, px, py);
+        store<V>(px, py, w, out + i);
+    }
+
+    if (i == n)
+        return;
+
+    // zero padded copy of the tail
+    double tail_ra[V::width], tail_dec[V::width];
+    for (std::size_t j(0); j < w; ++j)
+    {
+        tail_ra[j] = i + j < n ? ra[i + j] : 0.;
+        tail_dec[j] = i + j < n ? dec[i + j] : 0.;
+    }
+    Frame<V>::from_equatorial(V::load(tail_ra), V::load(tail_dec), x, y, z);
+    Frame<V>::rotate(params, x, y, z);
+    Projection::project(params, x, y, z, px, py);
+    store<V>(px, py, n - i, out + i);
+}
+
+template <typename V, typename Projection>
+void project_vectors(const simd::FrameParams & params,
+                     const SkyVector * pos, std::size_t n, CanvasPoint * out)
+{
+    const std::size_t w(V::width);
+    double px[V::width], py[V::width];
+    double vx[V::width], vy[V::width], vz[V::width];
+    for (std::size_t i(0); i < n; i += w)
+    {
+        const std::size_t count(n - i < w ? n - i : w);
+        for (std::size_t j(0); j < w; ++j)
+        {
+            const SkyVector & v(pos[i + (j < count ? j : 0)]);
+            vx[j] = v.x;
+            vy[j] = v.y;
+            vz[j] = v.z;
+        }
+        typename V::type x(V::load(vx)), y(V::load(vy)), z(V::load(vz));
+        Frame<V>::rotate(params, x, y, z);
+        Projection::project(params, x, y, z, px, py);
+        store<V>(px, py, count, out + i);
+    }
+}
+
+}
+
+// Table of kernels, in the order of simd::Map.
+#define ACHARTS_SIMD_KERNELS(V) {                                  \
+    {                                                               \
+        &project_equatorial<V, AzimuthalEquidistant<V>>,            \
+        &project_equatorial<V, AzimuthalEquidistantSeries<V>>,      \
+        &project_equatorial<V, Stereographic<V>>,                   \
+        &project_equatorial<V, Gnomonic<V>>,                        \
+        &project_equatorial<V, Orthographic<V>>,                    \
+        &project_equatorial<V, LambertAzimuthalEqualArea<V>>,       \
+        &project_equatorial<V, CylindricalEquidistant<V>>,          \
+        &project_equatorial<V, Mollweide<V>>,                       \
+        &project_equatorial<V, HammerAitoff<V>>                     \
+    },                                                              \
+    {                                                               \
+        &project_vectors<V, AzimuthalEquidistant<V>>,               \
+        &project_vectors<V, AzimuthalEquidistantSeries<V>>,         \
+        &project_vectors<V, Stereographic<V>>,                      \
+        &project_vectors<V, Gnomonic<V>>,                           \
+        &project_vectors<V, Orthographic<V>>,                       \
+        &project_vectors<V, LambertAzimuthalEqualArea<V>>,          \
+        &project_vectors<V, CylindricalEquidistant<V>>,             \
+        &project_vectors<V, Mollweide<V>>,                          \
+        &project_vectors<V, HammerAitoff<V>>                        \
+    }                                                               \
+}
+
+#endif
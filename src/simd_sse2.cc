@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "simd.hh"
+
+#include <emmintrin.h>
+
+namespace
+{
+
+struct Sse2
+{
+    typedef __m128d type;
+    typedef __m128d mask;
+    static const std::size_t width{2};
+
+    static type set1(double d) { return _mm_set1_pd(d); }
+    static type load(const double * p) { return _mm_loadu_pd(p); }
+    static void store(double * p, type v) { _mm_storeu_pd(p, v); }
+
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm_div_pd(a, b); }
+    static type sqrt(type a) { return _mm_sqrt_pd(a); }
+    static type min(type a, type b) { return _mm_min_pd(a, b); }
+    static type max(type a, type b) { return _mm_max_pd(a, b); }
+    static type abs(type a) { return _mm_andnot_pd(_mm_set1_pd(-0.), a); }
+    // only ever used on small non-negative values
+    static type trunc(type a) { return _mm_cvtepi32_pd(_mm_cvttpd_epi32(a)); }
+
+    static mask lt(type a, type b) { return _mm_cmplt_pd(a, b); }
+    static mask gt(type a, type b) { return _mm_cmpgt_pd(a, b); }
+    static mask ge(type a, type b) { return _mm_cmpge_pd(a, b); }
+    static mask eq(type a, type b) { return _mm_cmpeq_pd(a, b); }
+    static mask mask_or(mask a, mask b) { return _mm_or_pd(a, b); }
+    static bool any(mask m) { return 0 != _mm_movemask_pd(m); }
+    static type select(mask m, type a, type b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+};
+
+// Single precision, converting from and to double on loads and stores.
+struct Sse2Float
+{
+    typedef __m128 type;
+    typedef __m128 mask;
+    static const std::size_t width{4};
+
+    static type set1(double d) { return _mm_set1_ps(float(d)); }
+    static type load(const double * p)
+    {
+        return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+    }
+    static void store(double * p, type v)
+    {
+        _mm_storeu_pd(p, _mm_cvtps_pd(v));
+        _mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm_div_ps(a, b); }
+    static type sqrt(type a) { return _mm_sqrt_ps(a); }
+    static type min(type a, type b) { return _mm_min_ps(a, b); }
+    static type max(type a, type b) { return _mm_max_ps(a, b); }
+    static type abs(type a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    static type trunc(type a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+
+    static mask lt(type a, type b) { return _mm_cmplt_ps(a, b); }
+    static mask gt(type a, type b) { return _mm_cmpgt_ps(a, b); }
+    static mask ge(type a, type b) { return _mm_cmpge_ps(a, b); }
+    static mask eq(type a, type b) { return _mm_cmpeq_ps(a, b); }
+    static mask mask_or(mask a, mask b) { return _mm_or_ps(a, b); }
+    static bool any(mask m) { return 0 != _mm_movemask_ps(m); }
+    static type select(mask m, type a, type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+
+}
+
+#include "simd_kernels.hh"
+
+// constant initialised, nothing here may run before the CPU is checked
+const simd::Kernels simd::kernels_sse2 = ACHARTS_SIMD_KERNELS(Sse2);
+const simd::Kernels simd::kernels_sse2_single = ACHARTS_SIMD_KERNELS(Sse2Float);
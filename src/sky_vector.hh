@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_SKY_VECTOR_HH
+#define ACHARTS_SKY_VECTOR_HH 1
+
+#include <algorithm>
+#include <cmath>
+#include <libnova/ln_types.h>
+
+/*
+ * Position on the celestial sphere as a unit vector: x points to the
+ * vernal equinox, z to the north pole.  Converting a star once lets
+ * every later change of frame be a matrix product.
+ */
+struct SkyVector
+{
+    double x, y, z;
+
+    SkyVector()
+        : x(1.), y(0.), z(0.)
+    {
+    }
+
+    SkyVector(double x, double y, double z)
+        : x(x), y(y), z(z)
+    {
+    }
+
+    // pos in degrees
+    explicit SkyVector(const ln_equ_posn & pos)
+    {
+        const double ra(pos.ra * M_PI / 180.), dec(pos.dec * M_PI / 180.);
+        x = std::cos(dec) * std::cos(ra);
+        y = std::cos(dec) * std::sin(ra);
+        z = std::sin(dec);
+    }
+
+    // Back to degrees, ra in [0, 360).
+    ln_equ_posn equ() const
+    {
+        double ra(std::atan2(y, x) * 180. / M_PI);
+        if (ra < 0.)
+            ra += 360.;
+        return ln_equ_posn{ra, std::atan2(z, std::hypot(x, y)) * 180. / M_PI};
+    }
+};
+
+inline double dot(const SkyVector & l, const SkyVector & r)
+{
+    return l.x * r.x + l.y * r.y + l.z * r.z;
+}
+
+/*
+ * Spherical cap: all positions within an angle from the centre.  Testing
+ * a position takes a single dot product, so it's cheap enough to reject
+ * positions before projecting them.
+ */
+struct SkyCap
+{
+    SkyVector centre;
+    // cosine of the cap's angular radius
+    double min_cos;
+
+    static SkyCap whole_sky()
+    {
+        return SkyCap{SkyVector(), -1.};
+    }
+
+    bool contains(const SkyVector & v) const
+    {
+        return dot(centre, v) >= min_cos;
+    }
+
+    // Angular radius in degrees.
+    double radius() const
+    {
+        return std::acos(std::max(-1., std::min(1., min_cos))) * 180. / M_PI;
+    }
+};
+
+// Smallest cap containing both.
+inline SkyCap enclosing(const SkyCap & a, const SkyCap & b)
+{
+    const double ra(a.radius() * M_PI / 180.), rb(b.radius() * M_PI / 180.);
+    const double cos_d(std::max(-1., std::min(1., dot(a.centre, b.centre))));
+    const double d(std::acos(cos_d));
+    if (d + rb <= ra)
+        return a;
+    if (d + ra <= rb)
+        return b;
+
+    const double r((d + ra + rb) / 2.);
+    if (r >= M_PI)
+        return SkyCap::whole_sky();
+
+    // move a's centre by r - ra along the great circle towards b's
+    const SkyVector u(b.centre.x - cos_d * a.centre.x,
+                      b.centre.y - cos_d * a.centre.y,
+                      b.centre.z - cos_d * a.centre.z);
+    const double norm(std::sqrt(dot(u, u)));
+    if (norm == 0.)
+        return SkyCap::whole_sky();
+
+    const double s(std::sin(r - ra) / norm), c(std::cos(r - ra));
+    return SkyCap{SkyVector(c * a.centre.x + s * u.x,
+                            c * a.centre.y + s * u.y,
+                            c * a.centre.z + s * u.z),
+                  std::cos(r)};
+}
+
+/*
+ * Rotation of the sphere.  Products of rotations stay rotations, so
+ * any chain of them collapses into one matrix per chart.
+ */
+struct RotationMatrix
+{
+    double m[3][3];
+
+    static RotationMatrix identity()
+    {
+        return RotationMatrix{{{1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}}};
+    }
+
+    // Rotation by angle, in radians, counter-clockwise when looking
+    // from the tip of the axis towards the origin.
+    static RotationMatrix about_x(double angle)
+    {
+        const double s(std::sin(angle)), c(std::cos(angle));
+        return RotationMatrix{{{1., 0., 0.}, {0., c, -s}, {0., s, c}}};
+    }
+
+    static RotationMatrix about_y(double angle)
+    {
+        const double s(std::sin(angle)), c(std::cos(angle));
+        return RotationMatrix{{{c, 0., s}, {0., 1., 0.}, {-s, 0., c}}};
+    }
+
+    static RotationMatrix about_z(double angle)
+    {
+        const double s(std::sin(angle)), c(std::cos(angle));
+        return RotationMatrix{{{c, -s, 0.}, {s, c, 0.}, {0., 0., 1.}}};
+    }
+
+    SkyVector operator*(const SkyVector & v) const
+    {
+        return SkyVector(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                         m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                         m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    }
+
+    // Rotation applying rh first, then this.
+    RotationMatrix operator*(const RotationMatrix & rh) const
+    {
+        RotationMatrix ret;
+        for (int i(0); i < 3; ++i)
+        {
+            for (int j(0); j < 3; ++j)
+                ret.m[i][j] = m[i][0] * rh.m[0][j] + m[i][1] * rh.m[1][j] + m[i][2] * rh.m[2][j];
+        }
+        return ret;
+    }
+
+    // Inverse rotation.
+    RotationMatrix transposed() const
+    {
+        RotationMatrix ret;
+        for (int i(0); i < 3; ++i)
+        {
+            for (int j(0); j < 3; ++j)
+                ret.m[i][j] = m[j][i];
+        }
+        return ret;
+    }
+};
+
+#endif
@@ -50,6 +50,12 @@ SolarObjectManager::~SolarObjectManager()
 {
 }
 
+std::mutex & libnova_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
 const std::shared_ptr<const SolarObject> SolarObjectManager::get(const std::string & name) const
 {
     auto i(imp_->objects.find(boost::algorithm::to_lower_copy(name)));
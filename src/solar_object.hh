@@ -25,6 +25,7 @@
 
 #include <libnova/ln_types.h>
 #include <memory>
+#include <mutex>
 #include <string>
 
 class SolarObject
@@ -59,4 +60,8 @@ public:
     void put(const std::shared_ptr<const SolarObject> & object);
 };
 
+// libnova keeps its last nutation in statics, so calls into it from
+// several threads must hold this.
+std::mutex & libnova_mutex();
+
 #endif
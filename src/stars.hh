@@ -27,17 +27,20 @@
 #include <string>
 #include <vector>
 
+#include "sky_vector.hh"
+
 class Star
 {
 public:
     std::string common_name_;
     ln_equ_posn pos_;
+    SkyVector vec_;
     double vmag_;
 
     Star(const std::string & cname,
          const ln_equ_posn & pos,
          double vm)
-        : common_name_(cname), pos_(pos), vmag_(vm)
+        : common_name_(cname), pos_(pos), vec_(pos), vmag_(vm)
     { }
 
     struct by_mag
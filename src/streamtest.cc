@@ -20,17 +20,12 @@
  * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "gzstreambuf.hh"
-#include <fstream>
+#include "file_source.hh"
+#include "magic.hh"
 #include <iostream>
 
 int main()
 {
-/*    std::ifstream i("catalog.gz");
-    gzstreambuf gb(i.rdbuf());
-    std::istream in(&gb);
-    std::cout << in.rdbuf();
-*/
-    igzfstream ig("catalog.gz");
+    iblockstream ig(open_file_with_magic("catalog.gz"));
     std::cout << ig.rdbuf();
 }
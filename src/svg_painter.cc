@@ -22,7 +22,13 @@
  */
 #include "svg_painter.hh"
 
-#include <boost/variant/apply_visitor.hpp>
+#include <algorithm>
+#include <boost/variant/static_visitor.hpp>
+#include <limits>
+#include <vector>
+
+#include "label_placement.hh"
+#include "scene_index.hh"
 
 namespace
 {
@@ -33,112 +39,181 @@ double mag2size(double mag)
     return 2.0 * exp(-mag / e) + 0.1;
 }
 
+// Hands symbols and texts of a scene to placement, at their place on the
+// canvas.  Objects are identified by their address within the scene.
+class LabelCollector
+{
+    LabelPlacement & placement_;
+    const CanvasBox area_;
+    // position of insets being painted within the canvas
+    std::vector<CanvasPoint> offsets_;
+
+public:
+    LabelCollector(LabelPlacement & placement, const CanvasBox & area)
+        : placement_(placement),
+          area_(area),
+          offsets_(1)
+    {
+    }
+
+    bool begin(const scene::Group &)
+    {
+        offsets_.push_back(offsets_.back());
+        return true;
+    }
+
+    void begin(const scene::Inset & i)
+    {
+        offsets_.push_back(offsets_.back() + i.position);
+    }
+
+    void end()
+    {
+        offsets_.pop_back();
+    }
+
+    void operator()(const scene::Object &)
+    {
+    }
+
+    // the Sun, the Moon and planets first, then by brightness
+    void operator()(const scene::ProportionalObject & o)
+    {
+        const CanvasPoint pos(o.pos + offsets_.back());
+        if (area_.contains(pos))
+            placement_.add(&o, pos, o.radius, o.label, -std::numeric_limits<double>::infinity());
+    }
+
+    void operator()(const scene::LabelledObject & lo)
+    {
+        const CanvasPoint pos(lo.pos + offsets_.back());
+        if (area_.contains(pos))
+            placement_.add(&lo, pos, mag2size(lo.mag), lo.label, lo.mag);
+    }
+
+    void operator()(const scene::DirectedObject &)
+    {
+    }
+
+    void operator()(const scene::Rectangle &)
+    {
+    }
+
+    void operator()(const scene::Line &)
+    {
+    }
+
+    void operator()(const scene::Path &)
+    {
+    }
+
+    void operator()(const scene::Text & t)
+    {
+        const CanvasPoint pos(t.pos + offsets_.back());
+        if (area_.contains(pos))
+            placement_.obstacle(pos, t.body);
+    }
+};
+
+// Radius of the symbol of an element that labels keep off, negative for
+// elements that labels may cover.
+class SymbolRadius : public boost::static_visitor<double>
+{
+public:
+    double operator()(const scene::ProportionalObject * o) const
+    {
+        return o->radius;
+    }
+
+    double operator()(const scene::LabelledObject * lo) const
+    {
+        return mag2size(lo->mag);
+    }
+
+    template <typename Element>
+    double operator()(const Element &) const
+    {
+        return -1.;
+    }
+};
+
+// Whether box covers the middle of a symbol of symbols, as far as size
+// from where it is: discs of the brightest objects are wide enough to
+// hide others, so labels only keep off their middle.
+bool covers_symbol(const scene::SpatialIndex & symbols, double size, const CanvasBox & box)
+{
+    const CanvasBox range{CanvasPoint(box.start.x - size, box.start.y - size),
+                          CanvasPoint(box.end.x + size, box.end.y + size)};
+    bool covers(false);
+    symbols.query(range, [&](const scene::SpatialIndex::Item & item)
+                  {
+                      const double core(std::min(boost::apply_visitor(SymbolRadius(), item.element), size));
+                      const CanvasPoint & pos(symbols.box(item).start);
+                      if (core >= 0. && CanvasBox{CanvasPoint(pos.x - core, pos.y - core),
+                                                  CanvasPoint(pos.x + core, pos.y + core)}.overlaps(box))
+                          covers = true;
+                  });
+    return covers;
+}
+
+}
+
+std::string inset_group_id(const std::string & inset, const std::string & id)
+{
+    return inset + '-' + id;
 }
 
 struct SvgPainter::Implementation
 {
     const double canvas_margin_;
-    const CanvasPoint canvas_, canvas_start_, canvas_end_;
+    const CanvasPoint canvas_;
+    // bounds of the viewport being painted, with margin, and those
+    // of enclosing groups and insets
+    CanvasBox box_;
+    std::vector<CanvasBox> bounds_;
+    // id of the innermost inset being painted, if any, and of those
+    // around enclosing groups and insets
+    std::string inset_;
+    std::vector<std::string> insets_;
     const std::string style_;
+    // where labels go, if they have been placed
+    std::unique_ptr<LabelPlacement> labels_;
 
     Implementation(const CanvasPoint & canvas, double canvas_margin, const std::string & style)
         : canvas_margin_(canvas_margin),
           canvas_(canvas),
-          canvas_start_(-canvas.x / 2. - canvas_margin_, -canvas.y / 2. - canvas_margin_),
-          canvas_end_(canvas.x / 2. + canvas_margin_, canvas_.y / 2. + canvas_margin_),
+          box_(CanvasBox::around(canvas, canvas_margin)),
           style_(style)
     {
     }
 
+    // Display lists get culled to the same bounds as they are built, so
+    // these only guard against lists built without.
     bool in_canvas(const CanvasPoint & oc)
     {
-        return oc.x >= canvas_start_.x && oc.y >= canvas_start_.y &&
-            oc.x <= canvas_end_.x && oc.y <= canvas_end_.y;
+        return box_.contains(oc);
     }
 
-    enum {
-        inside = 0, // 0000
-        left   = 1, // 0001
-        right  = 2, // 0010
-        bottom = 4, // 0100
-        top    = 8  // 1000
-    };
-
-    int Outcode(const CanvasPoint & p)
+    bool CohenSutherland(CanvasPoint p0, CanvasPoint p1)
     {
-        int code(0);
-
-        if (p.x < canvas_start_.x)
-            code |= left;
-        else if (p.x > canvas_end_.x)
-            code |= right;
-
-        if (p.y < canvas_start_.y)
-            code |= bottom;
-        else if (p.y > canvas_end_.y)
-            code |= top;
-
-        return code;
+        return box_.crosses(p0, p1);
     }
 
-    bool CohenSutherland(CanvasPoint p0, CanvasPoint p1)
+    // Label of object at pos, next to its symbol of radius unless it has
+    // been placed elsewhere, or dropped.
+    void label(std::ostream & os, const void * object, const CanvasPoint & pos, double radius,
+               const std::string & text)
     {
-        int code0 = Outcode(p0);
-        int code1 = Outcode(p1);
-        bool ret(false);
-
-        while (true)
-        {
-            if (!(code0 | code1))
-            {
-                ret = true;
-                break;
-            }
-            else if (code0 & code1)
-            {
-                break;
-            }
-            else
-            {
-                CanvasPoint p;
-                int code = code0 ? code0 : code1;
-
-                // use formulas y = y0 + slope * (x - x0), x = x0 + (1 / slope) * (y - y0)
-                if (code & top)
-                {
-                    p.x = p0.x + (p1.x - p0.x) * (canvas_end_.y - p0.y) / (p1.y - p0.y);
-                    p.y = canvas_end_.y;
-                }
-                else if (code & bottom)
-                {
-                    p.x = p0.x + (p1.x - p0.x) * (canvas_start_.y - p0.y) / (p1.y - p0.y);
-                    p.y = canvas_start_.y;
-                }
-                else if (code & right)
-                {
-                    p.y = p0.y + (p1.y - p0.y) * (canvas_end_.x - p0.x) / (p1.x - p0.x);
-                    p.x = canvas_end_.x;
-                }
-                else if (code & left)
-                {
-                    p.y = p0.y + (p1.y - p0.y) * (canvas_start_.x - p0.x) / (p1.x - p0.x);
-                    p.x = canvas_start_.x;
-                }
-
-                if (code == code0)
-                {
-                    p0 = p;
-                    code0 = Outcode(p0);
-                }
-                else
-                {
-                    p1 = p;
-                    code1 = Outcode(p1);
-                }
-            }
-        }
-
-        return ret;
+        LabelPlacement::Label l{CanvasPoint(radius, 0.), LabelPlacement::Anchor::Start};
+        if (labels_ && ! labels_->find(object, l))
+            return;
+
+        os << "<text x='" << pos.x + l.at.x << "' y='" << pos.y + l.at.y << "'";
+        if (LabelPlacement::Anchor::Middle == l.anchor)
+            os << " text-anchor='middle'";
+        else if (LabelPlacement::Anchor::End == l.anchor)
+            os << " text-anchor='end'";
+        os << " dy='0.5ex'>" << text << "</text>\n";
     }
 };
 
@@ -160,13 +235,53 @@ SvgPainter::~SvgPainter()
     os_ << "</svg>\n";
 }
 
-void SvgPainter::operator()(const scene::Group & g)
+void SvgPainter::place_labels(const scene::Scene & scene, double size)
+{
+    const CanvasBox area(CanvasBox::around(imp_->canvas_, imp_->canvas_margin_));
+    imp_->labels_.reset(new LabelPlacement(area, size));
+
+    LabelCollector collector(*imp_->labels_, area);
+    scene.paint(collector);
+
+    const scene::SpatialIndex symbols(scene, area);
+    imp_->labels_->place([&symbols, size](const CanvasBox & box)
+                         {
+                             return covers_symbol(symbols, size, box);
+                         });
+}
+
+bool SvgPainter::begin(const scene::Group & g)
+{
+    imp_->bounds_.push_back(imp_->box_);
+    imp_->insets_.push_back(imp_->inset_);
+
+    os_ << "<g class='" << g.class_ << "' id='"
+        << (imp_->inset_.empty() || g.id.empty() ? g.id : inset_group_id(imp_->inset_, g.id)) << "'>\n";
+    return g.bounds.overlaps(imp_->box_);
+}
+
+void SvgPainter::begin(const scene::Inset & i)
+{
+    imp_->bounds_.push_back(imp_->box_);
+    imp_->box_ = CanvasBox::around(i.size, imp_->canvas_margin_);
+    imp_->insets_.push_back(imp_->inset_);
+    imp_->inset_ = i.id;
+
+    os_ << "<clipPath id='" << i.id << "_clip'>"
+        "<rect x='" << -i.size.x / 2. << "' y='" << -i.size.y / 2. << "' "
+        "width='" << i.size.x << "' height='" << i.size.y << "'/></clipPath>\n"
+        "<g class='inset' id='" << i.id << "' "
+        "transform='translate(" << i.position.x << ',' << i.position.y << ")' "
+        "clip-path='url(#" << i.id << "_clip)'>\n";
+}
+
+void SvgPainter::end()
 {
-    parent_ = & g;
+    imp_->box_ = imp_->bounds_.back();
+    imp_->bounds_.pop_back();
+    imp_->inset_ = imp_->insets_.back();
+    imp_->insets_.pop_back();
 
-    os_ << "<g class='" << g.class_ << "' id='" << g.id << "'>\n";
-    for_each(g.elements.begin(), g.elements.end(),
-             boost::apply_visitor(*this));
     os_ << "</g>\n";
 }
 
@@ -188,9 +303,8 @@ void SvgPainter::operator()(const scene::ProportionalObject & o)
 
     double stroke_width{0.2 * o.radius};
     os_ << "<circle cx='" << o.pos.x << "' cy='" << o.pos.y << "' "
-        "r='" << o.radius << "' stroke-width='" << stroke_width << "' />\n"
-        "<text x='" << o.pos.x + o.radius << "' y='" << o.pos.y << "' dy='0.5ex'>"
-        << o.label << "</text>\n";
+        "r='" << o.radius << "' stroke-width='" << stroke_width << "' />\n";
+    imp_->label(os_, &o, o.pos, o.radius, o.label);
 }
 
 void SvgPainter::operator()(const scene::LabelledObject & lo)
@@ -201,9 +315,8 @@ void SvgPainter::operator()(const scene::LabelledObject & lo)
     double radius{mag2size(lo.mag)},
         stroke_width{0.2 * radius};
     os_ << "<circle cx='" << lo.pos.x << "' cy='" << lo.pos.y << "' "
-        "r='" << radius << "' stroke-width='" << stroke_width << "' />\n"
-        "<text x='" << lo.pos.x + radius << "' y='" << lo.pos.y << "' dy='0.5ex'>"
-        << lo.label << "</text>\n";
+        "r='" << radius << "' stroke-width='" << stroke_width << "' />\n";
+    imp_->label(os_, &lo, lo.pos, radius, lo.label);
 }
 
 void SvgPainter::operator()(const scene::DirectedObject & o)
@@ -231,45 +344,38 @@ void SvgPainter::operator()(const scene::Path & path)
 {
 #if 0
     // drawing ugly control points, usefull for debugging
-    for (auto const & i : p.path)
+    for (auto i(path.begin); i != path.end; ++i)
     {
-        os_ << "<circle cx='" << i.p.x << "' cy='" << i.p.y << "' r='2px' fill='black' />\n";
-        os_ << "<circle cx='" << i.cm.x << "' cy='" << i.cm.y << "' r='1px' fill='blue' />\n";
-        os_ << "<circle cx='" << i.cp.x << "' cy='" << i.cp.y << "' r='1px' fill='green' />\n";
+        os_ << "<circle cx='" << i->p.x << "' cy='" << i->p.y << "' r='2px' fill='black' />\n";
+        os_ << "<circle cx='" << i->cm.x << "' cy='" << i->cm.y << "' r='1px' fill='blue' />\n";
+        os_ << "<circle cx='" << i->cp.x << "' cy='" << i->cp.y << "' r='1px' fill='green' />\n";
     }
 #endif
 
-    std::deque<BezierCurve> visibles(1);
+    // visible runs are streamed as they are found, one <path> each
+    bool open(false);
+    for (auto first(path.begin), second(first + 1), end(path.end);
+         second < end; first = second, ++second)
     {
-        for (auto first(path.path.cbegin()), second(first + 1), end(path.path.cend());
-             second != end; first = second, ++second)
+        if (imp_->CohenSutherland(first->p, second->p))
         {
-            if (imp_->CohenSutherland(first->p, second->p))
+            if (! open)
             {
-                if (visibles.back().empty())
-                    visibles.back().push_back(*first);
-                visibles.back().push_back(*second);
+                os_ << "<path d='M" << first->p.x << ',' << first->p.y << ' ';
+                open = true;
             }
-            else if (! visibles.back().empty())
-                visibles.push_back(BezierCurve{});
+            os_ << 'C' << first->cp.x << ',' << first->cp.y << ' '
+                << second->cm.x << ',' << second->cm.y << ' '
+                << second->p.x << ',' << second->p.y << ' ';
         }
-    }
-    for (auto const & p : visibles)
-    {
-        if (p.empty())
-            continue;
-        os_ << "<path d='";
-        auto prev(p.cbegin());
-        os_ << 'M' << prev->p.x << ',' << prev->p.y << ' ';
-        for (auto next(prev + 1), end(p.cend());
-             next != end; prev = next, ++next)
+        else if (open)
         {
-            os_ << 'C' << prev->cp.x << ',' << prev->cp.y << ' '
-                << next->cm.x << ',' << next->cm.y << ' '
-                << next->p.x << ',' << next->p.y << ' ';
+            os_ << "' />\n";
+            open = false;
         }
-        os_ << "' />\n";
     }
+    if (open)
+        os_ << "' />\n";
 }
 
 void SvgPainter::operator()(const scene::Text & t)
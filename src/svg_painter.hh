@@ -23,29 +23,40 @@
 #ifndef ACHARTS_SVG_PAINTER_HH_
 #define ACHARTS_SVG_PAINTER_HH_ 1
 
-#include <boost/variant/static_visitor.hpp>
 #include <memory>
+#include <string>
 
 #include "scene.hh"
 
+// Id of a group with id painted within an inset, which repeats groups
+// of the main chart: "inset1-planets" for "planets" in "inset1".
+std::string inset_group_id(const std::string & inset, const std::string & id);
+
+// Painter of a scene::DisplayList.
 class SvgPainter
-    : public boost::static_visitor<>
 {
     struct Implementation;
     std::unique_ptr<Implementation> imp_;
     std::ostream & os_;
-    const scene::Group * parent_;
 
 public:
     SvgPainter(std::ostream & os, const CanvasPoint & canvas, double canvas_margin, const std::string & style);
     ~SvgPainter();
     SvgPainter(const SvgPainter &) = delete;
-    
+
+    // Moves labels of objects of scene, of height size, off each other
+    // and off other objects, leaving out those that don't fit.  Before
+    // painting scene, which must stay as it is.
+    void place_labels(const scene::Scene & scene, double size);
+
     void operator()(const scene::Object & o);
     void operator()(const scene::ProportionalObject & o);
     void operator()(const scene::LabelledObject & lo);
     void operator()(const scene::DirectedObject & d);
-    void operator()(const scene::Group & g);
+    // Whether anything of g may be visible, false skipping to its end().
+    bool begin(const scene::Group & g);
+    void begin(const scene::Inset & i);
+    void end();
     void operator()(const scene::Rectangle & r);
     void operator()(const scene::Line & l);
     void operator()(const scene::Path & p);
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2012-2016 Łukasz P. Michalik <lpmichalik@googlemail.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ACHARTS_TASK_POOL_HH
+#define ACHARTS_TASK_POOL_HH 1
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Fixed set of worker threads taking tasks in order of submission.
+ * Results and exceptions come back through futures.  Destruction waits
+ * for every task submitted so far.
+ */
+class TaskPool
+{
+public:
+    // hardware concurrency, if workers is 0
+    explicit TaskPool(std::size_t workers = 0);
+    ~TaskPool();
+    TaskPool(const TaskPool &) = delete;
+    TaskPool & operator=(const TaskPool &) = delete;
+
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F f);
+
+private:
+    void work();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_;
+    std::vector<std::thread> workers_;
+};
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> TaskPool::submit(F f)
+{
+    typedef typename std::result_of<F()>::type R;
+    // std::function wants copies, packaged_task can only be moved
+    auto task(std::make_shared<std::packaged_task<R()>>(std::move(f)));
+    std::future<R> result(task->get_future());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back([task]() { (*task)(); });
+    }
+    ready_.notify_one();
+    return result;
+}
+
+#endif